@@ -0,0 +1,748 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_BTREE_MAP_H
+#define PHIL_TEMPLATE_LIBRARY_BTREE_MAP_H
+
+#include <ptl/ebo.hpp>
+#include <ptl/flat_tree.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/***
+  An ordered map for sizes where flatmap's linear insertion and erasure start to hurt, with (mostly) the same interface.
+  It is a B+tree: all elements live in leaves of up to leaf_capacity sorted elements, linked to their neighbours for iteration,
+  and inner nodes only hold separator keys. Nodes have a fixed size of about NODE_BYTES and are not allocated one by one,
+  but stored in two vectors and referenced by index, so the whole tree occupies a few large blocks of memory.
+  Lookups touch one node per level and the first few levels easily stay in cache, while insertion and erasure only ever shift within a single node.
+  Erasure does not rebalance, nodes are only removed once empty. Keys and mapped values have to be default constructible, as unused slots exist in every node.
+  Any insertion or erasure invalidates all iterators, moving the map does as well.
+***/
+
+namespace ptl
+{
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, std::size_t NODE_BYTES=256>
+	class btree_map: private ebo_bases<COMPARE_T>
+	{
+		using index_t=std::uint32_t;
+		static constexpr index_t no_node=std::numeric_limits<index_t>::max();
+		
+		public:
+		using key_type					=	KEY_T;
+		using mapped_type				=	MAPPED_T;
+		using value_type				=	std::pair<KEY_T,MAPPED_T>;
+		using size_type					=	std::size_t;
+		using difference_type			=	std::ptrdiff_t;
+		using key_compare				=	COMPARE_T;
+		
+		using reference					=	value_type&;
+		using const_reference			=	const value_type&;
+		
+		static constexpr std::size_t leaf_capacity=std::max<std::size_t>(4,(NODE_BYTES-3*sizeof(index_t))/sizeof(value_type));
+		static constexpr std::size_t inner_capacity=std::max<std::size_t>(4,(NODE_BYTES-2*sizeof(index_t))/(sizeof(key_type)+sizeof(index_t)));
+		
+		private:
+		template <typename TREE_T, typename VALUE_T>
+		class iterator_impl
+		{
+			public:
+			using iterator_category	=	std::bidirectional_iterator_tag;
+			using difference_type	=	std::ptrdiff_t;
+			using value_type		=	std::remove_const_t<VALUE_T>;
+			using reference			=	VALUE_T&;
+			using pointer			=	VALUE_T*;
+			
+			iterator_impl() = default;
+			
+			template <typename OTHER_TREE_T, typename OTHER_VALUE_T, typename = std::enable_if_t<std::is_convertible_v<OTHER_VALUE_T*,VALUE_T*>>>
+			iterator_impl(const iterator_impl<OTHER_TREE_T,OTHER_VALUE_T>& other):
+				tree_{other.tree_},
+				leaf_{other.leaf_},
+				pos_{other.pos_}
+			{}
+			
+			reference operator*() const { return tree_->leaves_[leaf_].values[pos_]; }
+			pointer operator->() const { return &**this; }
+			
+			iterator_impl& operator++()
+			{
+				if(++pos_==tree_->leaves_[leaf_].count)
+				{
+					leaf_=tree_->leaves_[leaf_].next;
+					pos_=0;
+				}
+				return *this;
+			}
+			
+			iterator_impl& operator--()
+			{
+				if(leaf_==no_node)
+				{
+					leaf_=tree_->last_leaf_;
+					pos_=tree_->leaves_[leaf_].count;
+				}
+				else if(pos_==0)
+				{
+					leaf_=tree_->leaves_[leaf_].prev;
+					pos_=tree_->leaves_[leaf_].count;
+				}
+				--pos_;
+				return *this;
+			}
+			
+			iterator_impl operator++(int) { auto ret_val=*this; ++*this; return ret_val; }
+			iterator_impl operator--(int) { auto ret_val=*this; --*this; return ret_val; }
+			
+			friend bool operator==(const iterator_impl& lhs, const iterator_impl& rhs) { return lhs.leaf_==rhs.leaf_ && lhs.pos_==rhs.pos_; }
+			friend bool operator!=(const iterator_impl& lhs, const iterator_impl& rhs) { return !(lhs==rhs); }
+			
+			private:
+			template <typename, typename> friend class iterator_impl;
+			friend class btree_map;
+			
+			//an empty leaf is never reachable from another one, so only position 0 of a leaf can be past its end
+			iterator_impl(TREE_T* tree, index_t leaf, index_t pos):
+				tree_{tree},
+				leaf_{leaf!=no_node && pos==tree->leaves_[leaf].count?tree->leaves_[leaf].next:leaf},
+				pos_{leaf!=no_node && pos==tree->leaves_[leaf].count?0:pos}
+			{}
+			
+			TREE_T* tree_=nullptr;
+			index_t leaf_=no_node;
+			index_t pos_=0;
+		};
+		
+		public:
+		using iterator					=	iterator_impl<btree_map,value_type>;
+		using const_iterator			=	iterator_impl<const btree_map,const value_type>;
+		using reverse_iterator			=	std::reverse_iterator<iterator>;
+		using const_reverse_iterator	=	std::reverse_iterator<const_iterator>;
+		
+		btree_map():
+			btree_map(COMPARE_T{})
+		{}
+		
+		explicit btree_map(const COMPARE_T& comp):
+			ebo_bases<COMPARE_T>{comp}
+		{
+			reset();
+		}
+		
+		template <typename ITER_T, typename = typename std::iterator_traits<ITER_T>::iterator_category>
+		btree_map(ITER_T first, ITER_T last, const COMPARE_T& comp=COMPARE_T{}):
+			btree_map(comp)
+		{
+			insert(first,last);
+		}
+		
+		//the caller promises the input to be sorted and free of duplicates, so the tree is built bottom up in a single pass
+		template <typename ITER_T>
+		btree_map(sorted_unique_t, ITER_T first, ITER_T last, const COMPARE_T& comp=COMPARE_T{}):
+			btree_map(comp)
+		{
+			bulk_load(std::vector<value_type>(first,last));
+		}
+		
+		btree_map(std::initializer_list<value_type> values, const COMPARE_T& comp=COMPARE_T{}):
+			btree_map(values.begin(),values.end(),comp)
+		{}
+		
+		auto begin() noexcept { return iterator{this,first_leaf_,0}; }
+		auto begin() const noexcept { return const_iterator{this,first_leaf_,0}; }
+		auto end() noexcept { return iterator{this,no_node,0}; }
+		auto end() const noexcept { return const_iterator{this,no_node,0}; }
+		
+		auto rbegin() noexcept { return reverse_iterator{end()}; }
+		auto rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		auto rend() noexcept { return reverse_iterator{begin()}; }
+		auto rend() const noexcept { return const_reverse_iterator{begin()}; }
+		
+		auto cbegin() const noexcept { return begin(); }
+		auto cend() const noexcept { return end(); }
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+		
+		auto empty() const noexcept { return size_==0; }
+		auto size() const noexcept { return size_; }
+		
+		//number of levels, 1 for a tree consisting of a single leaf
+		auto height() const noexcept { return height_+1; }
+		
+		void clear() { reset(); }
+		
+		auto find(const key_type& key) { return find_impl(*this,key); }
+		auto find(const key_type& key) const { return find_impl(*this,key); }
+		
+		size_type count(const key_type& key) const { return find(key)!=end()?1:0; }
+		bool contains(const key_type& key) const { return find(key)!=end(); }
+		
+		auto lower_bound(const key_type& key) { return lower_bound_impl(*this,key); }
+		auto lower_bound(const key_type& key) const { return lower_bound_impl(*this,key); }
+		
+		auto upper_bound(const key_type& key) { return upper_bound_impl(*this,key); }
+		auto upper_bound(const key_type& key) const { return upper_bound_impl(*this,key); }
+		
+		auto equal_range(const key_type& key) { return std::make_pair(lower_bound(key),upper_bound(key)); }
+		auto equal_range(const key_type& key) const { return std::make_pair(lower_bound(key),upper_bound(key)); }
+		
+		std::pair<iterator, bool> insert(const value_type &new_val) { return emplace_at_key(new_val.first,new_val); }
+		std::pair<iterator, bool> insert(value_type &&new_val) { return emplace_at_key(new_val.first,std::move(new_val)); }
+		
+		//there is nothing to gain from a hint here, the search is cheap compared to the insertion, but the interface should match flatmap's
+		iterator insert(const_iterator, const value_type &new_val) { return insert(new_val).first; }
+		iterator insert(const_iterator, value_type &&new_val) { return insert(std::move(new_val)).first; }
+		
+		//Small batches go in one by one, larger ones are merged with the current contents and the tree is rebuilt from scratch.
+		//Just as with flatmap, existing elements win over new ones and the first of several equal new ones wins over the others.
+		template <typename ITER_T>
+		void insert(ITER_T first, ITER_T last)
+		{
+			std::vector<value_type> new_values(first,last);
+			if(new_values.size()<size_/rebuild_ratio)
+			{
+				for(auto& new_val: new_values)
+					insert(std::move(new_val));
+				return;
+			}
+			
+			std::stable_sort(std::begin(new_values),std::end(new_values),value_compare());
+			
+			std::vector<value_type> merged;
+			merged.reserve(size_+new_values.size());
+			
+			auto it=begin();
+			for(auto& new_val: new_values)
+			{
+				for(;it!=end() && value_compare()(*it,new_val);++it)
+					merged.push_back(std::move(*it));
+				
+				const auto already_present=(it!=end() && !key_comp()(new_val.first,it->first)) || (!merged.empty() && !key_comp()(merged.back().first,new_val.first));
+				if(!already_present)
+					merged.push_back(std::move(new_val));
+			}
+			for(;it!=end();++it)
+				merged.push_back(std::move(*it));
+			
+			bulk_load(std::move(merged));
+		}
+		
+		void insert(std::initializer_list<value_type> values)
+		{
+			insert(values.begin(),values.end());
+		}
+		
+		template <typename ...ARG_T>
+		std::pair<iterator, bool> emplace(ARG_T&& ...args)
+		{
+			value_type new_val(std::forward<ARG_T>(args)...);
+			return emplace_at_key(new_val.first,std::move(new_val));
+		}
+		
+		template <typename ...ARG_T>
+		std::pair<iterator, bool> try_emplace(const key_type& key, ARG_T&& ...args)
+		{
+			return emplace_at_key(key,std::piecewise_construct,std::forward_as_tuple(key),std::forward_as_tuple(std::forward<ARG_T>(args)...));
+		}
+		
+		template <typename ...ARG_T>
+		std::pair<iterator, bool> try_emplace(key_type&& key, ARG_T&& ...args)
+		{
+			return emplace_at_key(key,std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::forward_as_tuple(std::forward<ARG_T>(args)...));
+		}
+		
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+		{
+			auto ret_val=try_emplace(key,std::forward<M>(obj));
+			if(!ret_val.second)
+				ret_val.first->second=std::forward<M>(obj);
+			return ret_val;
+		}
+		
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+		{
+			auto ret_val=try_emplace(std::move(key),std::forward<M>(obj));
+			if(!ret_val.second)
+				ret_val.first->second=std::forward<M>(obj);
+			return ret_val;
+		}
+		
+		iterator erase(const_iterator pos)
+		{
+			const auto leaf=pos.leaf_;
+			const auto idx=pos.pos_;
+			auto& node=leaves_[leaf];
+			
+			if(node.count>1 || height_==0)
+			{
+				std::move(std::begin(node.values)+idx+1,std::begin(node.values)+node.count,std::begin(node.values)+idx);
+				--node.count;
+				//do not keep whatever the last element owned alive
+				node.values[node.count]=value_type{};
+				--size_;
+				return iterator{this,leaf,idx};
+			}
+			
+			//the leaf is about to become empty, so it has to go, which needs the path to it
+			const auto next=node.next;
+			find_leaf_recording_path(node.values[0].first);
+			--size_;
+			remove_leaf(leaf);
+			return iterator{this,next,0};
+		}
+		
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			auto remaining=std::distance(first,last);
+			auto it=iterator{this,first.leaf_,first.pos_};
+			for(;remaining>0;--remaining)
+				it=erase(it);
+			return it;
+		}
+		
+		size_type erase(const key_type& key)
+		{
+			auto it=find(key);
+			if(it==end())
+				return 0;
+			
+			erase(it);
+			return 1;
+		}
+		
+		auto& operator[](const key_type &key)
+		{
+			return try_emplace(key).first->second;
+		}
+		
+		auto& operator[](key_type &&key)
+		{
+			return try_emplace(std::move(key)).first->second;
+		}
+		
+		const auto& operator[](const key_type &key) const
+		{
+			if(auto it=find(key); it!=end())
+				return it->second;
+			
+			throw std::out_of_range{"Tried to access nonexistent element with operator[] on a const object..."};
+		}
+		
+		key_compare key_comp() const { return this->get_ebo_base(typelist<COMPARE_T>{}); }
+		
+		void swap(btree_map& other)
+		{
+			using std::swap;
+			swap(static_cast<ebo_bases<COMPARE_T>&>(*this),static_cast<ebo_bases<COMPARE_T>&>(other));
+			swap(leaves_,other.leaves_);
+			swap(inners_,other.inners_);
+			swap(free_leaves_,other.free_leaves_);
+			swap(free_inners_,other.free_inners_);
+			swap(path_,other.path_);
+			swap(root_,other.root_);
+			swap(first_leaf_,other.first_leaf_);
+			swap(last_leaf_,other.last_leaf_);
+			swap(height_,other.height_);
+			swap(size_,other.size_);
+		}
+		
+		private:
+		//inserting fewer than size()/rebuild_ratio elements at once is cheaper one by one than rebuilding everything
+		static constexpr std::size_t rebuild_ratio=8;
+		
+		struct leaf_node
+		{
+			index_t prev=no_node;
+			index_t next=no_node;
+			index_t count=0;
+			std::array<value_type,leaf_capacity> values{};
+		};
+		
+		//child i holds the keys k with keys[i-1]<=k<keys[i]
+		struct inner_node
+		{
+			index_t count=0;
+			std::array<key_type,inner_capacity> keys{};
+			std::array<index_t,inner_capacity+1> children{};
+		};
+		
+		struct path_entry
+		{
+			index_t node;
+			index_t slot;
+		};
+		
+		std::vector<leaf_node> leaves_;
+		std::vector<inner_node> inners_;
+		std::vector<index_t> free_leaves_;
+		std::vector<index_t> free_inners_;
+		//the inner nodes visited by the last find_leaf_recording_path, root first
+		std::vector<path_entry> path_;
+		
+		index_t root_=0;
+		index_t first_leaf_=0;
+		index_t last_leaf_=0;
+		//number of inner levels, 0 if the root is a leaf
+		std::size_t height_=0;
+		size_type size_=0;
+		
+		auto value_compare() const
+		{
+			return [comp=key_comp()](const value_type& lhs, const value_type& rhs) { return comp(lhs.first,rhs.first); };
+		}
+		
+		void reset()
+		{
+			leaves_.clear();
+			inners_.clear();
+			free_leaves_.clear();
+			free_inners_.clear();
+			leaves_.emplace_back();
+			root_=first_leaf_=last_leaf_=0;
+			height_=0;
+			size_=0;
+		}
+		
+		index_t child_slot(const inner_node& node, const key_type& key) const
+		{
+			return static_cast<index_t>(std::upper_bound(std::begin(node.keys),std::begin(node.keys)+node.count,key,key_comp())-std::begin(node.keys));
+		}
+		
+		index_t find_leaf(const key_type& key) const
+		{
+			auto node=root_;
+			for(auto level=height_;level>0;--level)
+				node=inners_[node].children[child_slot(inners_[node],key)];
+			return node;
+		}
+		
+		index_t find_leaf_recording_path(const key_type& key)
+		{
+			path_.clear();
+			auto node=root_;
+			for(auto level=height_;level>0;--level)
+			{
+				const auto slot=child_slot(inners_[node],key);
+				path_.push_back(path_entry{node,slot});
+				node=inners_[node].children[slot];
+			}
+			return node;
+		}
+		
+		index_t lower_bound_in_leaf(const leaf_node& leaf, const key_type& key) const
+		{
+			const auto compare=[this](const value_type& lhs, const key_type& rhs) { return key_comp()(lhs.first,rhs); };
+			return static_cast<index_t>(std::lower_bound(std::begin(leaf.values),std::begin(leaf.values)+leaf.count,key,compare)-std::begin(leaf.values));
+		}
+		
+		template <typename const_deduced_self>
+		static auto lower_bound_impl(const_deduced_self& self, const key_type& key)
+		{
+			using iterator_t=std::conditional_t<std::is_const_v<const_deduced_self>,const_iterator,iterator>;
+			
+			const auto leaf=self.find_leaf(key);
+			return iterator_t{&self,leaf,self.lower_bound_in_leaf(self.leaves_[leaf],key)};
+		}
+		
+		template <typename const_deduced_self>
+		static auto upper_bound_impl(const_deduced_self& self, const key_type& key)
+		{
+			using iterator_t=std::conditional_t<std::is_const_v<const_deduced_self>,const_iterator,iterator>;
+			
+			const auto leaf=self.find_leaf(key);
+			const auto& node=self.leaves_[leaf];
+			const auto compare=[&](const key_type& lhs, const value_type& rhs) { return self.key_comp()(lhs,rhs.first); };
+			const auto pos=std::upper_bound(std::begin(node.values),std::begin(node.values)+node.count,key,compare)-std::begin(node.values);
+			return iterator_t{&self,leaf,static_cast<index_t>(pos)};
+		}
+		
+		template <typename const_deduced_self>
+		static auto find_impl(const_deduced_self& self, const key_type& key)
+		{
+			using iterator_t=std::conditional_t<std::is_const_v<const_deduced_self>,const_iterator,iterator>;
+			
+			const auto leaf=self.find_leaf(key);
+			const auto& node=self.leaves_[leaf];
+			const auto pos=self.lower_bound_in_leaf(node,key);
+			if(pos==node.count || self.key_comp()(key,node.values[pos].first))
+				return self.end();
+			return iterator_t{&self,leaf,pos};
+		}
+		
+		//Key is only used for searching and has to stay valid until the new element is constructed.
+		template <typename ...ARG_T>
+		std::pair<iterator, bool> emplace_at_key(const key_type& key, ARG_T&& ...args)
+		{
+			auto leaf=find_leaf_recording_path(key);
+			auto pos=lower_bound_in_leaf(leaves_[leaf],key);
+			if(pos<leaves_[leaf].count && !key_comp()(key,leaves_[leaf].values[pos].first))
+				return std::pair<iterator, bool>(iterator{this,leaf,pos},false);
+			
+			value_type new_val(std::forward<ARG_T>(args)...);
+			if(leaves_[leaf].count==leaf_capacity)
+			{
+				const auto right=split_leaf(leaf);
+				if(pos>leaves_[leaf].count)
+				{
+					pos-=leaves_[leaf].count;
+					leaf=right;
+				}
+			}
+			
+			auto& node=leaves_[leaf];
+			std::move_backward(std::begin(node.values)+pos,std::begin(node.values)+node.count,std::begin(node.values)+node.count+1);
+			node.values[pos]=std::move(new_val);
+			++node.count;
+			++size_;
+			return std::pair<iterator, bool>(iterator{this,leaf,pos},true);
+		}
+		
+		template <typename NODES_T>
+		static void reserve_nodes(NODES_T& nodes, std::size_t additional)
+		{
+			if(nodes.capacity()<nodes.size()+additional)
+				nodes.reserve(std::max(nodes.size()+additional,2*nodes.capacity()));
+		}
+		
+		index_t allocate_leaf()
+		{
+			if(!free_leaves_.empty())
+			{
+				const auto idx=free_leaves_.back();
+				free_leaves_.pop_back();
+				return idx;
+			}
+			
+			leaves_.emplace_back();
+			return static_cast<index_t>(leaves_.size()-1);
+		}
+		
+		index_t allocate_inner()
+		{
+			if(!free_inners_.empty())
+			{
+				const auto idx=free_inners_.back();
+				free_inners_.pop_back();
+				return idx;
+			}
+			
+			inners_.emplace_back();
+			return static_cast<index_t>(inners_.size()-1);
+		}
+		
+		//Moves the upper half of a full leaf into a new one and registers that with the parents, splitting them as well if need be.
+		//Requires path_ to lead to the leaf. Returns the index of the new leaf.
+		index_t split_leaf(index_t leaf)
+		{
+			//reserving everything up front means nothing past this point has to allocate
+			reserve_nodes(leaves_,1);
+			reserve_nodes(inners_,path_.size()+1);
+			
+			const auto right=allocate_leaf();
+			auto& left_node=leaves_[leaf];
+			auto& right_node=leaves_[right];
+			
+			const auto keep=left_node.count/2;
+			std::move(std::begin(left_node.values)+keep,std::begin(left_node.values)+left_node.count,std::begin(right_node.values));
+			right_node.count=left_node.count-keep;
+			left_node.count=keep;
+			
+			right_node.prev=leaf;
+			right_node.next=left_node.next;
+			if(left_node.next!=no_node)
+				leaves_[left_node.next].prev=right;
+			else
+				last_leaf_=right;
+			left_node.next=right;
+			
+			insert_into_parent(path_.size(),right_node.values[0].first,right);
+			return right;
+		}
+		
+		//adds right as the new child following the one at path_[level] (or the root, for level 0)
+		void insert_into_parent(std::size_t level, const key_type& separator, index_t right)
+		{
+			if(level==0)
+			{
+				const auto new_root=allocate_inner();
+				auto& node=inners_[new_root];
+				node.count=1;
+				node.keys[0]=separator;
+				node.children[0]=root_;
+				node.children[1]=right;
+				root_=new_root;
+				++height_;
+				return;
+			}
+			
+			const auto [parent,slot]=path_[level-1];
+			auto& node=inners_[parent];
+			if(node.count<inner_capacity)
+			{
+				std::move_backward(std::begin(node.keys)+slot,std::begin(node.keys)+node.count,std::begin(node.keys)+node.count+1);
+				std::move_backward(std::begin(node.children)+slot+1,std::begin(node.children)+node.count+1,std::begin(node.children)+node.count+2);
+				node.keys[slot]=separator;
+				node.children[slot+1]=right;
+				++node.count;
+				return;
+			}
+			
+			//Full, so we split the node, with the middle key moving up. Doing so via temporary arrays one larger than a node is simple and happens rarely enough.
+			std::array<key_type,inner_capacity+1> keys;
+			std::array<index_t,inner_capacity+2> children;
+			std::move(std::begin(node.keys),std::begin(node.keys)+slot,std::begin(keys));
+			keys[slot]=separator;
+			std::move(std::begin(node.keys)+slot,std::end(node.keys),std::begin(keys)+slot+1);
+			std::copy(std::begin(node.children),std::begin(node.children)+slot+1,std::begin(children));
+			children[slot+1]=right;
+			std::copy(std::begin(node.children)+slot+1,std::end(node.children),std::begin(children)+slot+2);
+			
+			const auto new_right=allocate_inner();
+			auto& left_node=inners_[parent];
+			auto& right_node=inners_[new_right];
+			
+			constexpr index_t mid=(inner_capacity+1)/2;
+			left_node.count=mid;
+			std::move(std::begin(keys),std::begin(keys)+mid,std::begin(left_node.keys));
+			std::copy(std::begin(children),std::begin(children)+mid+1,std::begin(left_node.children));
+			
+			right_node.count=static_cast<index_t>(inner_capacity-mid);
+			std::move(std::begin(keys)+mid+1,std::end(keys),std::begin(right_node.keys));
+			std::copy(std::begin(children)+mid+1,std::end(children),std::begin(right_node.children));
+			
+			insert_into_parent(level-1,keys[mid],new_right);
+		}
+		
+		//unlinks and frees an empty leaf, requires path_ to lead to it
+		void remove_leaf(index_t leaf)
+		{
+			auto& node=leaves_[leaf];
+			if(node.prev!=no_node)
+				leaves_[node.prev].next=node.next;
+			else
+				first_leaf_=node.next;
+			if(node.next!=no_node)
+				leaves_[node.next].prev=node.prev;
+			else
+				last_leaf_=node.prev;
+			
+			node=leaf_node{};
+			free_leaves_.push_back(leaf);
+			remove_child(path_.size());
+		}
+		
+		//removes the child at path_[level-1], freeing its parent as well if that was the only one
+		void remove_child(std::size_t level)
+		{
+			const auto [parent,slot]=path_[level-1];
+			auto& node=inners_[parent];
+			
+			if(node.count==0)
+			{
+				node=inner_node{};
+				free_inners_.push_back(parent);
+				if(level==1)
+					reset();
+				else
+					remove_child(level-1);
+				return;
+			}
+			
+			const auto key_slot=slot==0?0:slot-1;
+			std::move(std::begin(node.keys)+key_slot+1,std::begin(node.keys)+node.count,std::begin(node.keys)+key_slot);
+			std::copy(std::begin(node.children)+slot+1,std::begin(node.children)+node.count+1,std::begin(node.children)+slot);
+			--node.count;
+			node.keys[node.count]=key_type{};
+			
+			//a root with a single child is just an extra level to walk through
+			while(height_>0 && inners_[root_].count==0)
+			{
+				const auto old_root=root_;
+				root_=inners_[old_root].children[0];
+				inners_[old_root]=inner_node{};
+				free_inners_.push_back(old_root);
+				--height_;
+			}
+		}
+		
+		//builds the tree bottom up from sorted unique elements, filling every node completely
+		void bulk_load(std::vector<value_type> sorted)
+		{
+			reset();
+			if(sorted.empty())
+				return;
+			
+			const auto leaf_count=(sorted.size()+leaf_capacity-1)/leaf_capacity;
+			leaves_.resize(leaf_count);
+			
+			std::vector<index_t> level_nodes(leaf_count);
+			std::vector<key_type> level_keys;
+			level_keys.reserve(leaf_count);
+			for(std::size_t i=0;i<leaf_count;++i)
+			{
+				auto& leaf=leaves_[i];
+				const auto first=i*leaf_capacity;
+				const auto last=std::min(first+leaf_capacity,sorted.size());
+				std::move(std::begin(sorted)+first,std::begin(sorted)+last,std::begin(leaf.values));
+				leaf.count=static_cast<index_t>(last-first);
+				leaf.prev=i==0?no_node:static_cast<index_t>(i-1);
+				leaf.next=i+1==leaf_count?no_node:static_cast<index_t>(i+1);
+				
+				level_nodes[i]=static_cast<index_t>(i);
+				level_keys.push_back(leaf.values[0].first);
+			}
+			
+			first_leaf_=0;
+			last_leaf_=static_cast<index_t>(leaf_count-1);
+			size_=sorted.size();
+			
+			while(level_nodes.size()>1)
+			{
+				std::vector<index_t> parent_nodes;
+				std::vector<key_type> parent_keys;
+				for(std::size_t first=0;first<level_nodes.size();first+=inner_capacity+1)
+				{
+					const auto last=std::min(first+inner_capacity+1,level_nodes.size());
+					const auto idx=allocate_inner();
+					auto& node=inners_[idx];
+					
+					node.children[0]=level_nodes[first];
+					for(auto i=first+1;i<last;++i)
+					{
+						node.keys[i-first-1]=level_keys[i];
+						node.children[i-first]=level_nodes[i];
+					}
+					node.count=static_cast<index_t>(last-first-1);
+					
+					parent_nodes.push_back(idx);
+					parent_keys.push_back(level_keys[first]);
+				}
+				
+				level_nodes=std::move(parent_nodes);
+				level_keys=std::move(parent_keys);
+				++height_;
+			}
+			
+			root_=level_nodes[0];
+		}
+	};
+	
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T, std::size_t NODE_BYTES>
+	void swap(btree_map<KEY_T,MAPPED_T,COMPARE_T,NODE_BYTES>& lhs, btree_map<KEY_T,MAPPED_T,COMPARE_T,NODE_BYTES>& rhs)
+	{
+		lhs.swap(rhs);
+	}
+
+} //end namespace ptl
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_BUFFERED_FLATMAP_H
+#define PHIL_TEMPLATE_LIBRARY_BUFFERED_FLATMAP_H
+
+#include <ptl/flatmap.hpp>
+
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+/***
+  A flatmap for workloads mixing bursts of insertions with bursts of lookups.
+  New elements do not go into the main sorted storage, where each of them would have to shift everything behind it,
+  but into a second, small flatmap. Once that exceeds a given size (or compact() is called), it gets merged into the main one in a single pass.
+  Lookups simply search both, iteration merges them on the fly and is a plain walk over the main storage whenever the tail is empty.
+***/
+
+namespace ptl
+{
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T, typename CONTAINER_T>
+	class buffered_flatmap;
+	
+	namespace detail
+	{
+		template <typename FLATMAP_T, typename ITER_T>
+		class buffered_flatmap_iterator
+		{
+			public:
+			using iterator_category	=	std::bidirectional_iterator_tag;
+			using difference_type	=	typename std::iterator_traits<ITER_T>::difference_type;
+			using value_type		=	typename std::iterator_traits<ITER_T>::value_type;
+			using reference			=	typename std::iterator_traits<ITER_T>::reference;
+			using pointer			=	typename std::iterator_traits<ITER_T>::pointer;
+			
+			constexpr buffered_flatmap_iterator() = default;
+			
+			//main_it and tail_it have to be the same position in the merged sequence, i.e. the lower bounds of the same key
+			constexpr buffered_flatmap_iterator(FLATMAP_T* main, FLATMAP_T* tail, ITER_T main_it, ITER_T tail_it):
+				main_{main},
+				tail_{tail},
+				main_it_{main_it},
+				tail_it_{tail_it}
+			{}
+			
+			template <typename OTHER_FLATMAP_T, typename OTHER_ITER_T, typename = std::enable_if_t<std::is_convertible_v<OTHER_ITER_T,ITER_T>>>
+			constexpr buffered_flatmap_iterator(const buffered_flatmap_iterator<OTHER_FLATMAP_T,OTHER_ITER_T>& other):
+				main_{other.main_},
+				tail_{other.tail_},
+				main_it_{other.main_it_},
+				tail_it_{other.tail_it_}
+			{}
+			
+			constexpr reference operator*() const { return tail_is_current()?*tail_it_:*main_it_; }
+			constexpr pointer operator->() const { return &**this; }
+			
+			constexpr buffered_flatmap_iterator& operator++()
+			{
+				if(tail_is_current())
+					++tail_it_;
+				else
+					++main_it_;
+				return *this;
+			}
+			
+			//the predecessor is the larger of the two elements preceding our positions
+			constexpr buffered_flatmap_iterator& operator--()
+			{
+				if(main_it_==main_->begin())
+					--tail_it_;
+				else if(tail_it_==tail_->begin())
+					--main_it_;
+				else if(main_->key_comp()(std::prev(main_it_)->first,std::prev(tail_it_)->first))
+					--tail_it_;
+				else
+					--main_it_;
+				return *this;
+			}
+			
+			constexpr buffered_flatmap_iterator operator++(int) { auto ret_val=*this; ++*this; return ret_val; }
+			constexpr buffered_flatmap_iterator operator--(int) { auto ret_val=*this; --*this; return ret_val; }
+			
+			friend constexpr bool operator==(const buffered_flatmap_iterator& lhs, const buffered_flatmap_iterator& rhs)
+			{
+				return lhs.main_it_==rhs.main_it_ && lhs.tail_it_==rhs.tail_it_;
+			}
+			
+			friend constexpr bool operator!=(const buffered_flatmap_iterator& lhs, const buffered_flatmap_iterator& rhs) { return !(lhs==rhs); }
+			
+			private:
+			template <typename, typename> friend class buffered_flatmap_iterator;
+			template <typename, typename, typename, typename> friend class ptl::buffered_flatmap;
+			
+			FLATMAP_T* main_=nullptr;
+			FLATMAP_T* tail_=nullptr;
+			ITER_T main_it_{};
+			ITER_T tail_it_{};
+			
+			//keys never appear in both, so there are no ties to break
+			constexpr bool tail_is_current() const
+			{
+				return main_it_==main_->end() || (tail_it_!=tail_->end() && main_->key_comp()(tail_it_->first,main_it_->first));
+			}
+		};
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<std::pair<KEY_T,MAPPED_T>>>
+	class buffered_flatmap
+	{
+		using flatmap_t=ptl::flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>;
+		
+		public:
+		using key_type					=	KEY_T;
+		using mapped_type				=	MAPPED_T;
+		using value_type				=	std::pair<KEY_T,MAPPED_T>;
+		using size_type					=	typename flatmap_t::size_type;
+		using difference_type			=	typename flatmap_t::difference_type;
+		using key_compare				=	COMPARE_T;
+		
+		using reference					=	value_type&;
+		using const_reference			=	const value_type&;
+		
+		using iterator					=	detail::buffered_flatmap_iterator<flatmap_t,typename flatmap_t::iterator>;
+		using const_iterator			=	detail::buffered_flatmap_iterator<const flatmap_t,typename flatmap_t::const_iterator>;
+		using reverse_iterator			=	std::reverse_iterator<iterator>;
+		using const_reverse_iterator	=	std::reverse_iterator<const_iterator>;
+		
+		static constexpr size_type default_merge_threshold=256;
+		
+		buffered_flatmap():
+			buffered_flatmap(COMPARE_T{})
+		{}
+		
+		explicit buffered_flatmap(const COMPARE_T &comp, size_type merge_threshold=default_merge_threshold):
+			main_{comp},
+			tail_{comp},
+			merge_threshold_{merge_threshold}
+		{}
+		
+		auto begin() noexcept { return iterator{&main_,&tail_,main_.begin(),tail_.begin()}; }
+		auto begin() const noexcept { return const_iterator{&main_,&tail_,main_.begin(),tail_.begin()}; }
+		auto end() noexcept { return iterator{&main_,&tail_,main_.end(),tail_.end()}; }
+		auto end() const noexcept { return const_iterator{&main_,&tail_,main_.end(),tail_.end()}; }
+		
+		auto rbegin() noexcept { return reverse_iterator{end()}; }
+		auto rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		auto rend() noexcept { return reverse_iterator{begin()}; }
+		auto rend() const noexcept { return const_reverse_iterator{begin()}; }
+		
+		auto cbegin() const noexcept { return begin(); }
+		auto cend() const noexcept { return end(); }
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+		
+		auto empty() const noexcept { return main_.empty() && tail_.empty(); }
+		auto size() const noexcept { return main_.size()+tail_.size(); }
+		
+		size_type merge_threshold() const noexcept { return merge_threshold_; }
+		void set_merge_threshold(size_type merge_threshold) { merge_threshold_=merge_threshold; compact_if_needed(); }
+		
+		//merges the tail into the main storage, afterwards iteration is a plain walk over contiguous memory again
+		void compact()
+		{
+			if(tail_.empty())
+				return;
+			
+			main_.insert(std::make_move_iterator(tail_.begin()),std::make_move_iterator(tail_.end()));
+			tail_.erase(tail_.begin(),tail_.end());
+		}
+		
+		auto find(const key_type& key) { return find_impl(*this,key); }
+		auto find(const key_type& key) const { return find_impl(*this,key); }
+		
+		size_type count(const key_type& key) const { return find(key)!=end()?1:0; }
+		bool contains(const key_type& key) const { return find(key)!=end(); }
+		
+		auto lower_bound(const key_type& key) { return iterator{&main_,&tail_,main_.lower_bound(key),tail_.lower_bound(key)}; }
+		auto lower_bound(const key_type& key) const { return const_iterator{&main_,&tail_,main_.lower_bound(key),tail_.lower_bound(key)}; }
+		
+		auto upper_bound(const key_type& key) { return iterator{&main_,&tail_,main_.upper_bound(key),tail_.upper_bound(key)}; }
+		auto upper_bound(const key_type& key) const { return const_iterator{&main_,&tail_,main_.upper_bound(key),tail_.upper_bound(key)}; }
+		
+		std::pair<iterator, bool> insert(const value_type &new_val) { return try_emplace(new_val.first,new_val.second); }
+		std::pair<iterator, bool> insert(value_type &&new_val) { return try_emplace(std::move(new_val.first),std::move(new_val.second)); }
+		
+		//large batches are better off going straight to the main storage with flatmap's own sort and merge
+		template <typename ITER_T>
+		void insert(ITER_T first, ITER_T last)
+		{
+			compact();
+			main_.insert(first,last);
+		}
+		
+		template <typename ...ARG_T>
+		std::pair<iterator, bool> emplace(ARG_T&& ...args)
+		{
+			value_type new_val(std::forward<ARG_T>(args)...);
+			return try_emplace(std::move(new_val.first),std::move(new_val.second));
+		}
+		
+		template <typename K, typename ...ARG_T>
+		std::pair<iterator, bool> try_emplace(K&& key, ARG_T&& ...args)
+		{
+			if(auto it=find(key); it!=end())
+				return std::pair<iterator, bool>(it,false);
+			
+			auto tail_it=tail_.try_emplace(std::forward<K>(key),std::forward<ARG_T>(args)...).first;
+			if(tail_.size()<=merge_threshold_)
+				return std::pair<iterator, bool>(iterator{&main_,&tail_,main_.lower_bound(tail_it->first),tail_it},true);
+			
+			//the tail is gone after merging it, so we have to look up our new element again
+			const auto offset=std::distance(tail_.begin(),tail_it);
+			auto new_key=std::next(tail_.begin(),offset)->first;
+			compact();
+			return std::pair<iterator, bool>(find(new_key),true);
+		}
+		
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+		{
+			auto ret_val=try_emplace(key,std::forward<M>(obj));
+			if(!ret_val.second)
+				ret_val.first->second=std::forward<M>(obj);
+			return ret_val;
+		}
+		
+		iterator erase(const_iterator pos)
+		{
+			auto main_it=main_.begin()+(pos.main_it_-main_.cbegin());
+			auto tail_it=tail_.begin()+(pos.tail_it_-tail_.cbegin());
+			if(pos.tail_is_current())
+				tail_it=tail_.erase(tail_it);
+			else
+				main_it=main_.erase(main_it);
+			return iterator{&main_,&tail_,main_it,tail_it};
+		}
+		
+		size_type erase(const key_type& key)
+		{
+			return main_.erase(key)+tail_.erase(key);
+		}
+		
+		auto& operator[](const key_type &key)
+		{
+			return try_emplace(key).first->second;
+		}
+		
+		auto& operator[](key_type &&key)
+		{
+			return try_emplace(std::move(key)).first->second;
+		}
+		
+		const auto& operator[](const key_type &key) const
+		{
+			if(auto it=find(key); it!=end())
+				return it->second;
+			
+			throw std::out_of_range{"Tried to access nonexistent element with operator[] on a const object..."};
+		}
+		
+		key_compare key_comp() const { return main_.key_comp(); }
+		
+		private:
+		flatmap_t main_;
+		flatmap_t tail_;
+		size_type merge_threshold_;
+		
+		void compact_if_needed()
+		{
+			if(tail_.size()>merge_threshold_)
+				compact();
+		}
+		
+		template <typename const_deduced_self>
+		static auto find_impl(const_deduced_self& self, const key_type& key)
+		{
+			using iterator_t=std::conditional_t<std::is_const_v<const_deduced_self>,const_iterator,iterator>;
+			
+			auto main_it=self.main_.lower_bound(key);
+			auto tail_it=self.tail_.lower_bound(key);
+			
+			const auto found_in=[&](const auto& storage, const auto& it) { return it!=storage.end() && !self.key_comp()(key,it->first); };
+			if(found_in(self.main_,main_it) || found_in(self.tail_,tail_it))
+				return iterator_t{&self.main_,&self.tail_,main_it,tail_it};
+			return self.end();
+		}
+	};
+
+} //end namespace ptl
+
+#endif
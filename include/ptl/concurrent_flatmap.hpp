@@ -0,0 +1,222 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_CONCURRENT_FLATMAP_H
+#define PHIL_TEMPLATE_LIBRARY_CONCURRENT_FLATMAP_H
+
+#include <ptl/flatmap.hpp>
+#include <ptl/new.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+/***
+  A flatmap for the read mostly case, shared between threads. Readers work on immutable snapshots, published through an atomic pointer,
+  writers copy the current snapshot, modify the copy and publish it in place of the old one, all changes of one update becoming visible at once.
+  Old snapshots are reclaimed with epochs: each reader announces the global epoch in a slot of its own (on a cache line of its own) before grabbing
+  the current snapshot and clears it once done. A snapshot retired at epoch E can be freed as soon as no reader announces an epoch before E.
+  This makes looking something up wait-free and readers never write to memory shared with anyone else, writers are serialized by a mutex.
+  Updates copy the whole map, so batch changes into a single update whenever possible.
+***/
+
+namespace ptl
+{
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<std::pair<KEY_T,MAPPED_T>>>
+	class concurrent_flatmap
+	{
+		struct alignas(ptl::hardware_destructive_interference_size) reader_slot
+		{
+			//0 while not reading
+			std::atomic<std::uint64_t> epoch{0};
+			//only accessed with the writer mutex held
+			bool in_use=false;
+		};
+		
+		public:
+		using flatmap_type		=	ptl::flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>;
+		using key_type			=	KEY_T;
+		using mapped_type		=	MAPPED_T;
+		using value_type		=	std::pair<KEY_T,MAPPED_T>;
+		using size_type			=	typename flatmap_type::size_type;
+		
+		//Keeps the snapshot it points to alive, for as long as it exists. Only one per reader at a time.
+		class snapshot
+		{
+			public:
+			snapshot(snapshot&& other) noexcept:
+				slot_{std::exchange(other.slot_,nullptr)},
+				map_{other.map_}
+			{}
+			
+			snapshot& operator=(snapshot&&) = delete;
+			
+			~snapshot()
+			{
+				if(slot_)
+					slot_->epoch.store(0,std::memory_order_release);
+			}
+			
+			const flatmap_type& operator*() const noexcept { return *map_; }
+			const flatmap_type* operator->() const noexcept { return map_; }
+			
+			private:
+			friend class concurrent_flatmap;
+			
+			snapshot(reader_slot* slot, const flatmap_type* map) noexcept:
+				slot_{slot},
+				map_{map}
+			{}
+			
+			reader_slot* slot_;
+			const flatmap_type* map_;
+		};
+		
+		//A registered reader, to be used by a single thread only. Has to be destroyed before the map is.
+		class reader
+		{
+			public:
+			reader(reader&& other) noexcept:
+				owner_{std::exchange(other.owner_,nullptr)},
+				slot_{other.slot_}
+			{}
+			
+			reader& operator=(reader&&) = delete;
+			
+			~reader()
+			{
+				if(owner_)
+					owner_->release_slot(*slot_);
+			}
+			
+			//Announcing our epoch has to be ordered before loading the pointer, hence sequential consistency for both.
+			//Writers only increment the epoch after publishing, so whatever snapshot we get is not freed before we are done with it.
+			snapshot lock() const
+			{
+				slot_->epoch.store(owner_->global_epoch_.load());
+				return snapshot{slot_,owner_->current_.load()};
+			}
+			
+			//calls func with the current snapshot, the result must not refer to anything inside of it
+			template <typename FUNC_T>
+			auto read(FUNC_T&& func) const
+			{
+				auto snap=lock();
+				return std::forward<FUNC_T>(func)(*snap);
+			}
+			
+			private:
+			friend class concurrent_flatmap;
+			
+			reader(concurrent_flatmap* owner, reader_slot* slot) noexcept:
+				owner_{owner},
+				slot_{slot}
+			{}
+			
+			concurrent_flatmap* owner_;
+			reader_slot* slot_;
+		};
+		
+		concurrent_flatmap():
+			concurrent_flatmap(flatmap_type{})
+		{}
+		
+		explicit concurrent_flatmap(flatmap_type initial):
+			current_{new flatmap_type(std::move(initial))}
+		{}
+		
+		concurrent_flatmap(const concurrent_flatmap&) = delete;
+		concurrent_flatmap& operator=(const concurrent_flatmap&) = delete;
+		
+		~concurrent_flatmap()
+		{
+			delete current_.load();
+		}
+		
+		reader make_reader()
+		{
+			std::lock_guard lock{writer_mutex_};
+			
+			auto it=std::find_if(std::begin(slots_),std::end(slots_),[](const auto& slot) { return !slot.in_use; });
+			auto& slot=it!=std::end(slots_)?*it:slots_.emplace_back();
+			slot.in_use=true;
+			return reader{this,&slot};
+		}
+		
+		//Applies func to a copy of the current contents and publishes the result. Readers see either all of the changes or none.
+		template <typename FUNC_T>
+		void update(FUNC_T&& func)
+		{
+			std::lock_guard lock{writer_mutex_};
+			
+			auto new_map=std::make_unique<flatmap_type>(*current_.load(std::memory_order_relaxed));
+			std::forward<FUNC_T>(func)(*new_map);
+			publish(std::move(new_map));
+		}
+		
+		void assign(flatmap_type new_contents)
+		{
+			std::lock_guard lock{writer_mutex_};
+			publish(std::make_unique<flatmap_type>(std::move(new_contents)));
+		}
+		
+		//snapshots still in use by a reader when they were replaced are otherwise only freed by the next update
+		void reclaim()
+		{
+			std::lock_guard lock{writer_mutex_};
+			reclaim_unlocked();
+		}
+		
+		private:
+		struct retired_snapshot
+		{
+			std::unique_ptr<const flatmap_type> map;
+			std::uint64_t epoch;
+		};
+		
+		std::atomic<const flatmap_type*> current_;
+		std::atomic<std::uint64_t> global_epoch_{1};
+		
+		std::mutex writer_mutex_;
+		//a deque, as readers keep pointers to their slots
+		std::deque<reader_slot> slots_;
+		std::vector<retired_snapshot> retired_;
+		
+		void publish(std::unique_ptr<flatmap_type> new_map)
+		{
+			//once the old snapshot is unpublished, nothing may throw before it is safely stored away
+			retired_.reserve(retired_.size()+1);
+			
+			std::unique_ptr<const flatmap_type> old_map{current_.exchange(new_map.release())};
+			const auto epoch=global_epoch_.fetch_add(1)+1;
+			retired_.push_back(retired_snapshot{std::move(old_map),epoch});
+			
+			reclaim_unlocked();
+		}
+		
+		void reclaim_unlocked()
+		{
+			auto oldest_active=std::numeric_limits<std::uint64_t>::max();
+			for(const auto& slot: slots_)
+				if(const auto epoch=slot.epoch.load(); epoch!=0)
+					oldest_active=std::min(oldest_active,epoch);
+			
+			const auto reclaimable=[&](const auto& retired) { return retired.epoch<=oldest_active; };
+			retired_.erase(std::remove_if(std::begin(retired_),std::end(retired_),reclaimable),std::end(retired_));
+		}
+		
+		void release_slot(reader_slot& slot)
+		{
+			std::lock_guard lock{writer_mutex_};
+			slot.in_use=false;
+		}
+	};
+
+} //end namespace ptl
+
+#endif
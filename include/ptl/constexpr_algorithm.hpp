@@ -1,13 +1,29 @@
 #ifndef PHIL_TEMPLATE_LIBRARY_UTILITY_CONSTEXPR_ALGORITHM_H
 #define PHIL_TEMPLATE_LIBRARY_UTILITY_CONSTEXPR_ALGORITHM_H
 
+#include <ptl/type_traits.hpp>
+
 #include <algorithm>
+#include <array>
+#include <functional>
 #include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+/***
+  Constexpr versions of the standard algorithms which are not constexpr before C++20, written for constant evaluation rather than speed.
+  Outside of constant evaluation (as far as ptl::is_constant_evaluated can tell), they simply call their std counterparts instead,
+  so the same call is fine for compile time tables and for sorting millions of elements at runtime.
+  Overloads taking an execution policy are in parallel_algorithm.hpp, to keep <execution> (and with it, possibly, a dependency on TBB) out of here.
+***/
 
 namespace ptl {
 namespace constexpr_algorithm
 {
-	
+
 namespace detail
 {
 	template <typename ITER_T>
@@ -24,7 +40,7 @@ namespace detail
 		return d;
 	}
 }
-	
+
 template <typename ITER_T>
 constexpr auto distance(ITER_T first, ITER_T last)
 {
@@ -86,7 +102,7 @@ namespace detail
 				ptl::constexpr_algorithm::swap(*swap_with,*root);
 			else
 				return;
-				
+			
 			root=swap_with;
 			left=left_child(first,last,root);
 			right=right_child(first,last,root);
@@ -99,6 +115,9 @@ constexpr void make_heap(ITER_T first, ITER_T last, COMPARE_T compare)
 {
 	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"make_heap requires random access iterators ;_;");
 	
+	if(!::ptl::is_constant_evaluated())
+		return ::std::make_heap(first,last,compare);
+	
 	auto root=detail::heap_parent(first,last,last-1);
 	for(;;)
 	{
@@ -116,6 +135,9 @@ constexpr void make_heap(ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm
 template <typename ITER_T, typename COMPARE_T>
 constexpr void pop_heap(ITER_T first, ITER_T last, COMPARE_T compare)
 {
+	if(!::ptl::is_constant_evaluated())
+		return ::std::pop_heap(first,last,compare);
+	
 	--last;
 	::ptl::constexpr_algorithm::swap(*first,*last);
 	detail::siftdown_heap(first,last, first, compare);
@@ -124,6 +146,9 @@ constexpr void pop_heap(ITER_T first, ITER_T last, COMPARE_T compare)
 template <typename ITER_T, typename COMPARE_T>
 constexpr void sort_heap(ITER_T first, ITER_T last, COMPARE_T compare)
 {
+	if(!::ptl::is_constant_evaluated())
+		return ::std::sort_heap(first,last,compare);
+	
 	while(first!=last)
 	{
 		::ptl::constexpr_algorithm::pop_heap(first,last,compare);
@@ -135,17 +160,810 @@ template <typename ITER_T>
 constexpr void sort_heap(ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm::sort_heap(first,last,::std::less<>{}); }
 
 
+namespace detail
+{
+	//Everything in here only ever moves elements by swapping them, as std::pair's assignment operators are not constexpr before C++20.
+	
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void insertion_sort(ITER_T first, ITER_T last, COMPARE_T compare)
+	{
+		if(first==last)
+			return;
+		
+		for(auto current=first+1;current!=last;++current)
+			for(auto it=current;it!=first && compare(*it,*(it-1));--it)
+				::ptl::constexpr_algorithm::swap(*it,*(it-1));
+	}
+	
+	//Gives up once more than a handful of elements had to be moved, returns whether it succeeded sorting the range.
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr bool partial_insertion_sort(ITER_T first, ITER_T last, COMPARE_T compare)
+	{
+		constexpr ::std::size_t move_limit=8;
+		
+		if(first==last)
+			return true;
+		
+		::std::size_t moves=0;
+		for(auto current=first+1;current!=last;++current)
+		{
+			for(auto it=current;it!=first && compare(*it,*(it-1));--it)
+			{
+				::ptl::constexpr_algorithm::swap(*it,*(it-1));
+				++moves;
+			}
+			
+			if(moves>move_limit)
+				return current+1==last;
+		}
+		return true;
+	}
+	
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void sort2(ITER_T a, ITER_T b, COMPARE_T compare)
+	{
+		if(compare(*b,*a))
+			::ptl::constexpr_algorithm::swap(*a,*b);
+	}
+	
+	//afterwards *a<=*b<=*c
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void sort3(ITER_T a, ITER_T b, ITER_T c, COMPARE_T compare)
+	{
+		sort2(a,b,compare);
+		sort2(b,c,compare);
+		sort2(a,b,compare);
+	}
+	
+	//Partitions [first,last) around the pivot *first, with elements equal to it going to the right. Requires an element not less than the pivot after first.
+	//Returns the final position of the pivot and whether the range was already partitioned, in which case there was nothing to swap.
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr ::std::pair<ITER_T,bool> partition_right(ITER_T first, ITER_T last, COMPARE_T compare)
+	{
+		auto i=first;
+		auto j=last;
+		
+		while(compare(*++i,*first));
+		
+		//without any element less than the pivot, nothing stops us before first, so we have to check
+		if(i-1==first)
+			while(i<j && !compare(*--j,*first));
+		else
+			while(!compare(*--j,*first));
+		
+		const bool already_partitioned=i>=j;
+		while(i<j)
+		{
+			::ptl::constexpr_algorithm::swap(*i,*j);
+			while(compare(*++i,*first));
+			while(!compare(*--j,*first));
+		}
+		
+		const auto pivot_pos=i-1;
+		if(pivot_pos!=first)
+			::ptl::constexpr_algorithm::swap(*first,*pivot_pos);
+		return {pivot_pos,already_partitioned};
+	}
+	
+	//The mirror image, with elements equal to the pivot going to the left. Used when we know no element is less than the pivot,
+	//so it puts all of the elements equal to it in place at once and we only have to continue with the greater ones.
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr ITER_T partition_left(ITER_T first, ITER_T last, COMPARE_T compare)
+	{
+		auto i=first;
+		auto j=last;
+		
+		while(compare(*first,*--j));
+		
+		if(j+1==last)
+			while(i<j && !compare(*first,*++i));
+		else
+			while(!compare(*first,*++i));
+		
+		while(i<j)
+		{
+			::ptl::constexpr_algorithm::swap(*i,*j);
+			while(compare(*first,*--j));
+			while(!compare(*first,*++i));
+		}
+		
+		if(j!=first)
+			::ptl::constexpr_algorithm::swap(*first,*j);
+		return j;
+	}
+	
+	template <typename T>
+	constexpr int log2(T n)
+	{
+		int log=0;
+		while(n>1)
+		{
+			n/=2;
+			++log;
+		}
+		return log;
+	}
+	
+	//Pattern-defeating quicksort, after Orson Peters. Quicksort with a median of three pivot (median of medians for larger ranges) and insertion sort for small ones,
+	//which notices sorted runs and many equal keys, and shuffles things around a bit after unbalanced partitions.
+	//Once too many of those happened, it falls back to heapsort, so we stay in O(n log n) no matter the input.
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void pdqsort(ITER_T first, ITER_T last, COMPARE_T compare, int bad_allowed, bool leftmost)
+	{
+		constexpr auto insertion_sort_threshold=24;
+		constexpr auto ninther_threshold=128;
+		
+		for(;;)
+		{
+			const auto size=last-first;
+			if(size<insertion_sort_threshold)
+			{
+				insertion_sort(first,last,compare);
+				return;
+			}
+			
+			//the median ends up at first, the last element is not less than it, which partition_right relies on
+			const auto half=size/2;
+			if(size>ninther_threshold)
+			{
+				sort3(first,first+half,last-1,compare);
+				sort3(first+1,first+(half-1),last-2,compare);
+				sort3(first+2,first+(half+1),last-3,compare);
+				sort3(first+(half-1),first+half,first+(half+1),compare);
+				::ptl::constexpr_algorithm::swap(*first,*(first+half));
+			}
+			else
+				sort3(first+half,first,last-1,compare);
+			
+			//If the element before this range, which is not greater than anything in it, equals the pivot, there are no smaller elements in here at all.
+			//All the equal ones go to the left and are done already.
+			if(!leftmost && !compare(*(first-1),*first))
+			{
+				first=partition_left(first,last,compare)+1;
+				continue;
+			}
+			
+			const auto [pivot_pos,already_partitioned]=partition_right(first,last,compare);
+			
+			const auto left_size=pivot_pos-first;
+			const auto right_size=last-(pivot_pos+1);
+			if(left_size<size/8 || right_size<size/8)
+			{
+				if(--bad_allowed==0)
+				{
+					::ptl::constexpr_algorithm::make_heap(first,last,compare);
+					::ptl::constexpr_algorithm::sort_heap(first,last,compare);
+					return;
+				}
+				
+				//break up whatever pattern caused this
+				if(left_size>=insertion_sort_threshold)
+				{
+					::ptl::constexpr_algorithm::swap(*first,*(first+left_size/4));
+					::ptl::constexpr_algorithm::swap(*(pivot_pos-1),*(pivot_pos-left_size/4));
+				}
+				
+				if(right_size>=insertion_sort_threshold)
+				{
+					::ptl::constexpr_algorithm::swap(*(pivot_pos+1),*(pivot_pos+1+right_size/4));
+					::ptl::constexpr_algorithm::swap(*(last-1),*(last-right_size/4));
+				}
+			}
+			else if(already_partitioned && partial_insertion_sort(first,pivot_pos,compare) && partial_insertion_sort(pivot_pos+1,last,compare))
+				return;
+			
+			//recursing into the smaller half only keeps the depth logarithmic
+			if(left_size<right_size)
+			{
+				pdqsort(first,pivot_pos,compare,bad_allowed,leftmost);
+				first=pivot_pos+1;
+				leftmost=false;
+			}
+			else
+			{
+				pdqsort(pivot_pos+1,last,compare,bad_allowed,false);
+				last=pivot_pos;
+			}
+		}
+	}
+}
+
 template <typename ITER_T, typename COMPARE_T>
 constexpr void sort(ITER_T first, ITER_T last, COMPARE_T compare)
 {
-	//heapsort because im lazy... xD
-	::ptl::constexpr_algorithm::make_heap(first,last,compare);
-	::ptl::constexpr_algorithm::sort_heap(first,last,compare);
+	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"sort requires random access iterators ;_;");
+	
+	if(!::ptl::is_constant_evaluated())
+		return ::std::sort(first,last,compare);
+	
+	if(last-first<2)
+		return;
+	
+	detail::pdqsort(first,last,compare,detail::log2(last-first),true);
 }
 
 template <typename ITER_T>
 constexpr void sort(ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm::sort(first,last,::std::less<>{}); }
 
+namespace detail
+{
+	template <typename ITER_T, typename DIFF_T>
+	constexpr void advance(ITER_T& it, DIFF_T n, ::std::random_access_iterator_tag)
+	{
+		it+=n;
+	}
+	
+	template <typename ITER_T, typename DIFF_T>
+	constexpr void advance(ITER_T& it, DIFF_T n, ::std::input_iterator_tag)
+	{
+		while(n-->0) ++it;
+	}
+}
+
+template <typename ITER_T, typename DIFF_T>
+constexpr ITER_T next(ITER_T it, DIFF_T n)
+{
+	detail::advance(it,n,typename ::std::iterator_traits<ITER_T>::iterator_category{});
+	return it;
+}
+
+namespace detail
+{
+	//std::pair's assignment is not constexpr before C++20, so we assign its members one by one
+	template <typename T, typename U>
+	constexpr void assign(T&& target, U&& value)
+	{
+		::std::forward<T>(target)=::std::forward<U>(value);
+	}
+	
+	template <typename T1, typename T2, typename U>
+	constexpr void assign(::std::pair<T1,T2>& target, U&& value)
+	{
+		detail::assign(target.first,::std::forward<U>(value).first);
+		detail::assign(target.second,::std::forward<U>(value).second);
+	}
+	
+	template <typename IN_ITER_T, typename OUT_ITER_T>
+	constexpr OUT_ITER_T copy(IN_ITER_T first, IN_ITER_T last, OUT_ITER_T out)
+	{
+		for(;first!=last;++first,++out)
+			detail::assign(*out,*first);
+		return out;
+	}
+	
+	template <typename IN_ITER_T, typename OUT_ITER_T>
+	constexpr OUT_ITER_T move(IN_ITER_T first, IN_ITER_T last, OUT_ITER_T out)
+	{
+		for(;first!=last;++first,++out)
+			detail::assign(*out,::std::move(*first));
+		return out;
+	}
+	
+	template <typename ITER_T>
+	constexpr void reverse(ITER_T first, ITER_T last)
+	{
+		while(first!=last && first!=--last)
+		{
+			::ptl::constexpr_algorithm::swap(*first,*last);
+			++first;
+		}
+	}
+	
+	template <typename ITER_T>
+	constexpr ITER_T rotate(ITER_T first, ITER_T middle, ITER_T last)
+	{
+		const auto new_middle=::ptl::constexpr_algorithm::next(first,::ptl::constexpr_algorithm::distance(middle,last));
+		detail::reverse(first,middle);
+		detail::reverse(middle,last);
+		detail::reverse(first,last);
+		return new_middle;
+	}
+}
+
+template <typename ITER_T, typename T, typename COMPARE_T>
+constexpr ITER_T lower_bound(ITER_T first, ITER_T last, const T& value, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::lower_bound(first,last,value,compare);
+	
+	auto length=::ptl::constexpr_algorithm::distance(first,last);
+	while(length>0)
+	{
+		const auto half=length/2;
+		const auto middle=::ptl::constexpr_algorithm::next(first,half);
+		if(compare(*middle,value))
+		{
+			first=::ptl::constexpr_algorithm::next(middle,1);
+			length-=half+1;
+		}
+		else
+			length=half;
+	}
+	return first;
+}
+
+template <typename ITER_T, typename T>
+constexpr ITER_T lower_bound(ITER_T first, ITER_T last, const T& value) { return ::ptl::constexpr_algorithm::lower_bound(first,last,value,::std::less<>{}); }
+
+template <typename ITER_T, typename T, typename COMPARE_T>
+constexpr ITER_T upper_bound(ITER_T first, ITER_T last, const T& value, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::upper_bound(first,last,value,compare);
+	
+	auto length=::ptl::constexpr_algorithm::distance(first,last);
+	while(length>0)
+	{
+		const auto half=length/2;
+		const auto middle=::ptl::constexpr_algorithm::next(first,half);
+		if(!compare(value,*middle))
+		{
+			first=::ptl::constexpr_algorithm::next(middle,1);
+			length-=half+1;
+		}
+		else
+			length=half;
+	}
+	return first;
+}
+
+template <typename ITER_T, typename T>
+constexpr ITER_T upper_bound(ITER_T first, ITER_T last, const T& value) { return ::ptl::constexpr_algorithm::upper_bound(first,last,value,::std::less<>{}); }
+
+template <typename ITER_T, typename T, typename COMPARE_T>
+constexpr ::std::pair<ITER_T,ITER_T> equal_range(ITER_T first, ITER_T last, const T& value, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::equal_range(first,last,value,compare);
+	
+	auto lower=::ptl::constexpr_algorithm::lower_bound(first,last,value,compare);
+	return {lower,::ptl::constexpr_algorithm::upper_bound(lower,last,value,compare)};
+}
+
+template <typename ITER_T, typename T>
+constexpr ::std::pair<ITER_T,ITER_T> equal_range(ITER_T first, ITER_T last, const T& value) { return ::ptl::constexpr_algorithm::equal_range(first,last,value,::std::less<>{}); }
+
+template <typename ITER_T, typename COMPARE_T>
+constexpr ITER_T is_sorted_until(ITER_T first, ITER_T last, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::is_sorted_until(first,last,compare);
+	
+	if(first==last)
+		return last;
+	
+	for(auto next=first;++next!=last;first=next)
+		if(compare(*next,*first))
+			return next;
+	return last;
+}
+
+template <typename ITER_T>
+constexpr ITER_T is_sorted_until(ITER_T first, ITER_T last) { return ::ptl::constexpr_algorithm::is_sorted_until(first,last,::std::less<>{}); }
+
+template <typename ITER_T, typename COMPARE_T>
+constexpr bool is_sorted(ITER_T first, ITER_T last, COMPARE_T compare)
+{
+	return ::ptl::constexpr_algorithm::is_sorted_until(first,last,compare)==last;
+}
+
+template <typename ITER_T>
+constexpr bool is_sorted(ITER_T first, ITER_T last) { return ::ptl::constexpr_algorithm::is_sorted(first,last,::std::less<>{}); }
+
+template <typename ITER_T, typename PREDICATE_T>
+constexpr ITER_T unique(ITER_T first, ITER_T last, PREDICATE_T equal)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::unique(first,last,equal);
+	
+	if(first==last)
+		return last;
+	
+	auto result=first;
+	while(++first!=last)
+		if(!equal(*result,*first) && ++result!=first)
+			detail::assign(*result,::std::move(*first));
+	return ++result;
+}
+
+template <typename ITER_T>
+constexpr ITER_T unique(ITER_T first, ITER_T last) { return ::ptl::constexpr_algorithm::unique(first,last,::std::equal_to<>{}); }
+
+namespace detail
+{
+	template <typename ITER_T, typename PREDICATE_T>
+	constexpr ITER_T partition(ITER_T first, ITER_T last, PREDICATE_T predicate, ::std::forward_iterator_tag)
+	{
+		while(first!=last && predicate(*first))
+			++first;
+		if(first==last)
+			return first;
+		
+		for(auto it=::ptl::constexpr_algorithm::next(first,1);it!=last;++it)
+		{
+			if(predicate(*it))
+			{
+				::ptl::constexpr_algorithm::swap(*it,*first);
+				++first;
+			}
+		}
+		return first;
+	}
+	
+	//from both ends, which only swaps elements which are actually on the wrong side
+	template <typename ITER_T, typename PREDICATE_T>
+	constexpr ITER_T partition(ITER_T first, ITER_T last, PREDICATE_T predicate, ::std::bidirectional_iterator_tag)
+	{
+		for(;;)
+		{
+			while(first!=last && predicate(*first))
+				++first;
+			
+			do
+			{
+				if(first==last)
+					return first;
+				--last;
+			} while(!predicate(*last));
+			
+			::ptl::constexpr_algorithm::swap(*first,*last);
+			++first;
+		}
+	}
+}
+
+template <typename ITER_T, typename PREDICATE_T>
+constexpr ITER_T partition(ITER_T first, ITER_T last, PREDICATE_T predicate)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::partition(first,last,predicate);
+	
+	return detail::partition(first,last,predicate,typename ::std::iterator_traits<ITER_T>::iterator_category{});
+}
+
+//Quickselect with the same pivot choice and partitioning as sort. Should it keep picking bad pivots, it simply sorts what is left.
+template <typename ITER_T, typename COMPARE_T>
+constexpr void nth_element(ITER_T first, ITER_T nth, ITER_T last, COMPARE_T compare)
+{
+	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"nth_element requires random access iterators ;_;");
+	
+	if(!::ptl::is_constant_evaluated())
+		return ::std::nth_element(first,nth,last,compare);
+	
+	constexpr auto insertion_sort_threshold=24;
+	
+	if(nth==last)
+		return;
+	
+	auto bad_allowed=detail::log2(last-first);
+	while(last-first>=insertion_sort_threshold)
+	{
+		const auto size=last-first;
+		detail::sort3(first+size/2,first,last-1,compare);
+		const auto pivot_pos=detail::partition_right(first,last,compare).first;
+		
+		if(pivot_pos==nth)
+			return;
+		
+		const auto left_size=pivot_pos-first;
+		const auto right_size=last-(pivot_pos+1);
+		if((left_size<size/8 || right_size<size/8) && --bad_allowed==0)
+		{
+			::ptl::constexpr_algorithm::sort(first,last,compare);
+			return;
+		}
+		
+		if(nth<pivot_pos)
+			last=pivot_pos;
+		else
+			first=pivot_pos+1;
+	}
+	
+	detail::insertion_sort(first,last,compare);
+}
+
+template <typename ITER_T>
+constexpr void nth_element(ITER_T first, ITER_T nth, ITER_T last) { ::ptl::constexpr_algorithm::nth_element(first,nth,last,::std::less<>{}); }
+
+//Stable, just like std::merge. Of equivalent elements, the ones from the first range come first.
+template <typename ITER1_T, typename ITER2_T, typename OUT_ITER_T, typename COMPARE_T>
+constexpr OUT_ITER_T merge(ITER1_T first1, ITER1_T last1, ITER2_T first2, ITER2_T last2, OUT_ITER_T out, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::merge(first1,last1,first2,last2,out,compare);
+	
+	for(;first1!=last1 && first2!=last2;++out)
+	{
+		if(compare(*first2,*first1))
+		{
+			detail::assign(*out,*first2);
+			++first2;
+		}
+		else
+		{
+			detail::assign(*out,*first1);
+			++first1;
+		}
+	}
+	
+	return detail::copy(first2,last2,detail::copy(first1,last1,out));
+}
+
+template <typename ITER1_T, typename ITER2_T, typename OUT_ITER_T>
+constexpr OUT_ITER_T merge(ITER1_T first1, ITER1_T last1, ITER2_T first2, ITER2_T last2, OUT_ITER_T out)
+{
+	return ::ptl::constexpr_algorithm::merge(first1,last1,first2,last2,out,::std::less<>{});
+}
+
+namespace detail
+{
+	//No buffer to allocate during constant evaluation, so we split the larger half in the middle, find where that element goes in the other half,
+	//rotate the two middle parts into place and continue on both sides. O(n log n) swaps instead of O(n) moves, but stable and needs no memory.
+	template <typename ITER_T, typename DIFF_T, typename COMPARE_T>
+	constexpr void merge_without_buffer(ITER_T first, ITER_T middle, ITER_T last, DIFF_T length1, DIFF_T length2, COMPARE_T compare)
+	{
+		if(length1==0 || length2==0)
+			return;
+		
+		if(length1+length2==2)
+		{
+			if(compare(*middle,*first))
+				::ptl::constexpr_algorithm::swap(*first,*middle);
+			return;
+		}
+		
+		auto cut1=first;
+		auto cut2=middle;
+		DIFF_T length11=0;
+		DIFF_T length22=0;
+		if(length1>length2)
+		{
+			length11=length1/2;
+			cut1=::ptl::constexpr_algorithm::next(first,length11);
+			cut2=::ptl::constexpr_algorithm::lower_bound(middle,last,*cut1,compare);
+			length22=::ptl::constexpr_algorithm::distance(middle,cut2);
+		}
+		else
+		{
+			length22=length2/2;
+			cut2=::ptl::constexpr_algorithm::next(middle,length22);
+			cut1=::ptl::constexpr_algorithm::upper_bound(first,middle,*cut2,compare);
+			length11=::ptl::constexpr_algorithm::distance(first,cut1);
+		}
+		
+		const auto new_middle=detail::rotate(cut1,middle,cut2);
+		detail::merge_without_buffer(first,cut1,new_middle,length11,length22,compare);
+		detail::merge_without_buffer(new_middle,cut2,last,length1-length11,length2-length22,compare);
+	}
+}
+
+template <typename ITER_T, typename COMPARE_T>
+constexpr void inplace_merge(ITER_T first, ITER_T middle, ITER_T last, COMPARE_T compare)
+{
+	if(!::ptl::is_constant_evaluated())
+		return ::std::inplace_merge(first,middle,last,compare);
+	
+	detail::merge_without_buffer(first,middle,last,::ptl::constexpr_algorithm::distance(first,middle),::ptl::constexpr_algorithm::distance(middle,last),compare);
+}
+
+template <typename ITER_T>
+constexpr void inplace_merge(ITER_T first, ITER_T middle, ITER_T last) { ::ptl::constexpr_algorithm::inplace_merge(first,middle,last,::std::less<>{}); }
+
+namespace detail
+{
+	constexpr ::std::ptrdiff_t stable_sort_run_length=32;
+	
+	//insertion sort only ever swaps neighbours which are out of order, so it is stable
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void sort_runs(ITER_T first, ITER_T last, COMPARE_T compare)
+	{
+		const auto size=last-first;
+		for(decltype(last-first) run=0;run<size;run+=stable_sort_run_length)
+			detail::insertion_sort(first+run,first+::std::min(run+stable_sort_run_length,size),compare);
+	}
+	
+	//merge, but moving the elements. Not done with move iterators, since the comparison should still see lvalues.
+	template <typename ITER1_T, typename ITER2_T, typename OUT_ITER_T, typename COMPARE_T>
+	constexpr OUT_ITER_T move_merge(ITER1_T first1, ITER1_T last1, ITER2_T first2, ITER2_T last2, OUT_ITER_T out, COMPARE_T compare)
+	{
+		for(;first1!=last1 && first2!=last2;++out)
+		{
+			if(compare(*first2,*first1))
+			{
+				detail::assign(*out,::std::move(*first2));
+				++first2;
+			}
+			else
+			{
+				detail::assign(*out,::std::move(*first1));
+				++first1;
+			}
+		}
+		
+		return detail::move(first2,last2,detail::move(first1,last1,out));
+	}
+	
+	template <typename SOURCE_ITER_T, typename DEST_ITER_T, typename DIFF_T, typename COMPARE_T>
+	constexpr void merge_pass(SOURCE_ITER_T source, DIFF_T size, DIFF_T width, DEST_ITER_T dest, COMPARE_T compare)
+	{
+		for(DIFF_T first=0;first<size;first+=2*width)
+		{
+			const auto middle=::std::min(first+width,size);
+			const auto last=::std::min(first+2*width,size);
+			detail::move_merge(source+first,source+middle,source+middle,source+last,dest+first,compare);
+		}
+	}
+}
+
+//Bottom-up merge sort without extra memory, merging in place. Takes O(n log² n), the overload below is faster if you can spare a buffer.
+//Outside of constant evaluation, std::stable_sort is free to allocate and does.
+template <typename ITER_T, typename COMPARE_T>
+constexpr void stable_sort(ITER_T first, ITER_T last, COMPARE_T compare)
+{
+	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"stable_sort requires random access iterators ;_;");
+	
+	if(!::ptl::is_constant_evaluated())
+		return ::std::stable_sort(first,last,compare);
+	
+	const auto size=last-first;
+	detail::sort_runs(first,last,compare);
+	for(auto width=static_cast<decltype(size)>(detail::stable_sort_run_length);width<size;width*=2)
+		for(decltype(width) left=0;left+width<size;left+=2*width)
+			::ptl::constexpr_algorithm::inplace_merge(first+left,first+left+width,first+::std::min(left+2*width,size),compare);
+}
+
+template <typename ITER_T>
+constexpr void stable_sort(ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm::stable_sort(first,last,::std::less<>{}); }
+
+//Bottom-up merge sort in O(n log n), merging back and forth between the range and the buffer, which has to hold at least as many elements.
+//Used at runtime as well, as whoever passes a buffer presumably does not want std::stable_sort to allocate one.
+template <typename ITER_T, typename T, ::std::size_t NUM, typename COMPARE_T>
+constexpr void stable_sort(ITER_T first, ITER_T last, ::std::array<T,NUM>& buffer, COMPARE_T compare)
+{
+	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"stable_sort requires random access iterators ;_;");
+	
+	const auto size=last-first;
+	if(static_cast<::std::size_t>(size)>NUM)
+		throw ::std::length_error{"Buffer too small for stable_sort ;_;"};
+	
+	detail::sort_runs(first,last,compare);
+	
+	bool in_buffer=false;
+	for(auto width=static_cast<decltype(size)>(detail::stable_sort_run_length);width<size;width*=2)
+	{
+		if(in_buffer)
+			detail::merge_pass(buffer.begin(),size,width,first,compare);
+		else
+			detail::merge_pass(first,size,width,buffer.begin(),compare);
+		in_buffer=!in_buffer;
+	}
+	
+	if(in_buffer)
+		detail::move(buffer.begin(),buffer.begin()+size,first);
+}
+
+template <typename ITER_T, typename T, ::std::size_t NUM>
+constexpr void stable_sort(ITER_T first, ITER_T last, ::std::array<T,NUM>& buffer) { ::ptl::constexpr_algorithm::stable_sort(first,last,buffer,::std::less<>{}); }
+
+
+namespace detail
+{
+	struct network_comparator
+	{
+		::std::size_t lhs;
+		::std::size_t rhs;
+	};
+	
+	//Batcher's merge exchange (Knuth's algorithm 5.2.2M), which unlike the textbook odd-even merge sort works for any number of elements.
+	//Optimal networks are only known for a handful of sizes, Batcher's are within a few comparators of them up to 32 elements.
+	template <typename FUNC_T>
+	constexpr void merge_exchange_network(::std::size_t num, FUNC_T&& func)
+	{
+		if(num<2)
+			return;
+		
+		::std::size_t t=0;
+		while((::std::size_t{1}<<t)<num)
+			++t;
+		
+		for(auto p=::std::size_t{1}<<(t-1);p>0;p/=2)
+		{
+			auto q=::std::size_t{1}<<(t-1);
+			::std::size_t r=0;
+			for(auto d=p;d>0;)
+			{
+				for(::std::size_t i=0;i+d<num;++i)
+					if((i & p)==r)
+						func(i,i+d);
+				
+				d=q-p;
+				q/=2;
+				r=p;
+			}
+		}
+	}
+	
+	template <::std::size_t NUM>
+	struct sorting_network
+	{
+		static constexpr ::std::size_t count_comparators()
+		{
+			::std::size_t count=0;
+			merge_exchange_network(NUM,[&](::std::size_t, ::std::size_t) { ++count; });
+			return count;
+		}
+		
+		static constexpr auto generate()
+		{
+			::std::array<network_comparator,count_comparators()> comparators{};
+			::std::size_t idx=0;
+			merge_exchange_network(NUM,[&](::std::size_t lhs, ::std::size_t rhs)
+			{
+				comparators[idx].lhs=lhs;
+				comparators[idx].rhs=rhs;
+				++idx;
+			});
+			return comparators;
+		}
+		
+		static constexpr auto comparators=generate();
+	};
+	
+	//For scalars, two selects instead of a conditional swap, which compilers turn into cmov or min/max instead of a branch they keep mispredicting.
+	template <typename ITER_T, typename COMPARE_T>
+	constexpr void compare_exchange(ITER_T first, ::std::size_t lhs_idx, ::std::size_t rhs_idx, COMPARE_T& compare)
+	{
+		auto& lhs=first[lhs_idx];
+		auto& rhs=first[rhs_idx];
+		
+		if constexpr(::std::is_scalar<typename ::std::iterator_traits<ITER_T>::value_type>::value)
+		{
+			const bool swap_needed=compare(rhs,lhs);
+			const auto smaller=swap_needed?rhs:lhs;
+			const auto larger=swap_needed?lhs:rhs;
+			lhs=smaller;
+			rhs=larger;
+		}
+		else if(compare(rhs,lhs))
+			::ptl::constexpr_algorithm::swap(lhs,rhs);
+	}
+	
+	template <::std::size_t NUM, typename ITER_T, typename COMPARE_T, ::std::size_t ...IDX>
+	constexpr void apply_sorting_network(ITER_T first, COMPARE_T& compare, ::std::index_sequence<IDX...>)
+	{
+		constexpr auto& comparators=sorting_network<NUM>::comparators;
+		(detail::compare_exchange(first,comparators[IDX].lhs,comparators[IDX].rhs,compare), ...);
+	}
+	
+	//above this, the networks get large enough for their code size to hurt more than the missing branches help
+	constexpr ::std::size_t max_sorting_network_size=32;
+}
+
+//Sorts the NUM elements starting at first with a sorting network generated at compile time, completely unrolled.
+template <::std::size_t NUM, typename ITER_T, typename COMPARE_T>
+constexpr void sort_fixed(ITER_T first, COMPARE_T compare)
+{
+	static_assert(::std::is_convertible<typename ::std::iterator_traits<ITER_T>::iterator_category, ::std::random_access_iterator_tag>::value,"sort_fixed requires random access iterators ;_;");
+	
+	detail::apply_sorting_network<NUM>(first,compare,::std::make_index_sequence<detail::sorting_network<NUM>::comparators.size()>{});
+}
+
+template <::std::size_t NUM, typename ITER_T>
+constexpr void sort_fixed(ITER_T first) { ::ptl::constexpr_algorithm::sort_fixed<NUM>(first,::std::less<>{}); }
+
+//Small arrays are sorted by a sorting network, at compile time and at runtime, everything else like any other range.
+template <typename T, ::std::size_t NUM, typename COMPARE_T>
+constexpr void sort(::std::array<T,NUM>& arr, COMPARE_T compare)
+{
+	if constexpr(NUM<=detail::max_sorting_network_size)
+		::ptl::constexpr_algorithm::sort_fixed<NUM>(arr.begin(),compare);
+	else
+		::ptl::constexpr_algorithm::sort(arr.begin(),arr.end(),compare);
+}
+
+template <typename T, ::std::size_t NUM>
+constexpr void sort(::std::array<T,NUM>& arr) { ::ptl::constexpr_algorithm::sort(arr,::std::less<>{}); }
+
 }}
 
 #endif
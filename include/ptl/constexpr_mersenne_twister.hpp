@@ -1,10 +1,23 @@
 #ifndef PHIL_TEMPLATE_LIBRARY_CONSTEXPR_MERSENNE_TWISTER_H
 #define PHIL_TEMPLATE_LIBRARY_CONSTEXPR_MERSENNE_TWISTER_H
 
+#include <ptl/type_traits.hpp>
+
+#include <algorithm>
 #include <array>
+#include <bitset>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
 
+#include <cstddef>
 #include <cstdint>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace ptl
 {
 
@@ -18,6 +31,262 @@ namespace detail
 			ret_val=(ret_val<<1)|1;
 		return ret_val;
 	}
+	
+	//The handful of operations the twister needs, on as many lanes as the widest vector registers we were compiled for have.
+	//Only for 32 and 64 bit state types, the unsigned integers all our instances use.
+	#if defined(__AVX2__)
+	using mt_vector=__m256i;
+	
+	inline mt_vector mt_load(const void* ptr) noexcept { return _mm256_loadu_si256(static_cast<const mt_vector*>(ptr)); }
+	inline void mt_store(void* ptr, mt_vector value) noexcept { _mm256_storeu_si256(static_cast<mt_vector*>(ptr),value); }
+	inline mt_vector mt_and(mt_vector lhs, mt_vector rhs) noexcept { return _mm256_and_si256(lhs,rhs); }
+	inline mt_vector mt_or(mt_vector lhs, mt_vector rhs) noexcept { return _mm256_or_si256(lhs,rhs); }
+	inline mt_vector mt_xor(mt_vector lhs, mt_vector rhs) noexcept { return _mm256_xor_si256(lhs,rhs); }
+	
+	template <typename T>
+	inline mt_vector mt_broadcast(T value) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm256_set1_epi32(static_cast<std::int32_t>(value));
+		else
+			return _mm256_set1_epi64x(static_cast<std::int64_t>(value));
+	}
+	
+	template <typename T>
+	inline mt_vector mt_shift_right(mt_vector value, int count) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm256_srli_epi32(value,count);
+		else
+			return _mm256_srli_epi64(value,count);
+	}
+	
+	template <typename T>
+	inline mt_vector mt_shift_left(mt_vector value, int count) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm256_slli_epi32(value,count);
+		else
+			return _mm256_slli_epi64(value,count);
+	}
+	
+	//all ones in lanes whose lowest bit is set, zero otherwise
+	template <typename T>
+	inline mt_vector mt_lowest_bit_mask(mt_vector value) noexcept
+	{
+		const auto lowest_bit=_mm256_and_si256(value,mt_broadcast<T>(1));
+		if constexpr(sizeof(T)==4)
+			return _mm256_sub_epi32(_mm256_setzero_si256(),lowest_bit);
+		else
+			return _mm256_sub_epi64(_mm256_setzero_si256(),lowest_bit);
+	}
+	#elif defined(__SSE2__)
+	using mt_vector=__m128i;
+	
+	inline mt_vector mt_load(const void* ptr) noexcept { return _mm_loadu_si128(static_cast<const mt_vector*>(ptr)); }
+	inline void mt_store(void* ptr, mt_vector value) noexcept { _mm_storeu_si128(static_cast<mt_vector*>(ptr),value); }
+	inline mt_vector mt_and(mt_vector lhs, mt_vector rhs) noexcept { return _mm_and_si128(lhs,rhs); }
+	inline mt_vector mt_or(mt_vector lhs, mt_vector rhs) noexcept { return _mm_or_si128(lhs,rhs); }
+	inline mt_vector mt_xor(mt_vector lhs, mt_vector rhs) noexcept { return _mm_xor_si128(lhs,rhs); }
+	
+	template <typename T>
+	inline mt_vector mt_broadcast(T value) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm_set1_epi32(static_cast<std::int32_t>(value));
+		else
+			return _mm_set1_epi64x(static_cast<std::int64_t>(value));
+	}
+	
+	template <typename T>
+	inline mt_vector mt_shift_right(mt_vector value, int count) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm_srli_epi32(value,count);
+		else
+			return _mm_srli_epi64(value,count);
+	}
+	
+	template <typename T>
+	inline mt_vector mt_shift_left(mt_vector value, int count) noexcept
+	{
+		if constexpr(sizeof(T)==4)
+			return _mm_slli_epi32(value,count);
+		else
+			return _mm_slli_epi64(value,count);
+	}
+	
+	template <typename T>
+	inline mt_vector mt_lowest_bit_mask(mt_vector value) noexcept
+	{
+		const auto lowest_bit=_mm_and_si128(value,mt_broadcast<T>(1));
+		if constexpr(sizeof(T)==4)
+			return _mm_sub_epi32(_mm_setzero_si128(),lowest_bit);
+		else
+			return _mm_sub_epi64(_mm_setzero_si128(),lowest_bit);
+	}
+	#endif
+	
+	//Polynomials over GF(2) for jumping ahead, bit i of the packed words being the coefficient of x^i.
+	using gf2_polynomial=std::vector<std::uint64_t>;
+	
+	inline std::size_t gf2_words(std::size_t bits) noexcept { return (bits+63)/64; }
+	inline bool gf2_bit(const gf2_polynomial& poly, std::size_t idx) noexcept { return (poly[idx/64]>>(idx%64))&1; }
+	inline void gf2_flip(gf2_polynomial& poly, std::size_t idx) noexcept { poly[idx/64]^=std::uint64_t{1}<<(idx%64); }
+	
+	//the 64 bits starting at bit offset, anything past the end being 0
+	inline std::uint64_t gf2_chunk(const gf2_polynomial& poly, std::size_t offset) noexcept
+	{
+		const auto word=offset/64;
+		const auto shift=offset%64;
+		if(word>=poly.size())
+			return 0;
+		
+		auto chunk=poly[word]>>shift;
+		if(shift!=0 && word+1<poly.size())
+			chunk|=poly[word+1]<<(64-shift);
+		return chunk;
+	}
+	
+	//target^=source*x^shift, target has to be large enough
+	inline void gf2_add_shifted(gf2_polynomial& target, const gf2_polynomial& source, std::size_t shift) noexcept
+	{
+		const auto word_shift=shift/64;
+		const auto bit_shift=shift%64;
+		for(std::size_t i=0;i<source.size() && i+word_shift<target.size();++i)
+		{
+			target[i+word_shift]^=source[i]<<bit_shift;
+			if(bit_shift!=0 && i+word_shift+1<target.size())
+				target[i+word_shift+1]^=source[i]>>(64-bit_shift);
+		}
+	}
+	
+	//Berlekamp-Massey: the shortest linear recurrence producing sequence, as its length L and connection polynomial 1+c_1x+...+c_Lx^L.
+	//The sequence is stored reversed, so the discrepancy of each step is the parity of a plain word by word AND with the connection polynomial.
+	inline std::pair<gf2_polynomial,std::size_t> gf2_berlekamp_massey(const std::vector<bool>& sequence)
+	{
+		const auto count=sequence.size();
+		gf2_polynomial reversed(gf2_words(count)+1);
+		for(std::size_t i=0;i<count;++i)
+			if(sequence[i])
+				gf2_flip(reversed,count-1-i);
+		
+		gf2_polynomial connection(gf2_words(count+1)+1);
+		auto previous=connection;
+		connection[0]=previous[0]=1;
+		std::size_t length=0;
+		std::size_t shift=1;
+		
+		for(std::size_t i=0;i<count;++i)
+		{
+			std::uint64_t discrepancy=0;
+			for(std::size_t word=0;word<=length/64;++word)
+				discrepancy^=connection[word]&gf2_chunk(reversed,count-1-i+64*word);
+			
+			if(std::bitset<64>{discrepancy}.count()%2==0)
+				++shift;
+			else if(2*length<=i)
+			{
+				auto tmp=connection;
+				gf2_add_shifted(connection,previous,shift);
+				length=i+1-length;
+				previous=std::move(tmp);
+				shift=1;
+			}
+			else
+			{
+				gf2_add_shifted(connection,previous,shift);
+				++shift;
+			}
+		}
+		
+		connection.resize(gf2_words(length+1));
+		return {std::move(connection),length};
+	}
+	
+	//The modulus of degree degree, shifted by 0 to 63 bits, so reducing by it only ever needs whole word XORs.
+	struct gf2_modulus
+	{
+		std::array<gf2_polynomial,64> shifted;
+		std::size_t degree;
+		
+		gf2_modulus(const gf2_polynomial& modulus, std::size_t degree):
+			degree{degree}
+		{
+			for(std::size_t shift=0;shift<64;++shift)
+			{
+				shifted[shift].resize(modulus.size()+1);
+				gf2_add_shifted(shifted[shift],modulus,shift);
+			}
+		}
+	};
+	
+	//poly mod modulus, for poly of degree less than twice that of modulus
+	inline void gf2_reduce(gf2_polynomial& poly, const gf2_modulus& modulus)
+	{
+		for(auto idx=poly.size()*64;idx-->modulus.degree;)
+		{
+			if(!gf2_bit(poly,idx))
+				continue;
+			
+			const auto offset=idx-modulus.degree;
+			const auto& shifted=modulus.shifted[offset%64];
+			const auto word_offset=offset/64;
+			const auto words=std::min(shifted.size(),poly.size()-word_offset);
+			for(std::size_t i=0;i<words;++i)
+				poly[word_offset+i]^=shifted[i];
+		}
+		poly.resize(gf2_words(modulus.degree));
+	}
+	
+	//squaring over GF(2) merely spreads the bits out, every cross term appears twice and cancels
+	inline std::uint64_t gf2_spread(std::uint32_t half) noexcept
+	{
+		std::uint64_t bits=half;
+		bits=(bits|(bits<<16))&0x0000ffff0000ffffull;
+		bits=(bits|(bits<<8))&0x00ff00ff00ff00ffull;
+		bits=(bits|(bits<<4))&0x0f0f0f0f0f0f0f0full;
+		bits=(bits|(bits<<2))&0x3333333333333333ull;
+		bits=(bits|(bits<<1))&0x5555555555555555ull;
+		return bits;
+	}
+	
+	inline gf2_polynomial gf2_square_mod(const gf2_polynomial& poly, const gf2_modulus& modulus)
+	{
+		gf2_polynomial square(2*poly.size());
+		for(std::size_t i=0;i<poly.size();++i)
+		{
+			square[2*i]=gf2_spread(static_cast<std::uint32_t>(poly[i]));
+			square[2*i+1]=gf2_spread(static_cast<std::uint32_t>(poly[i]>>32));
+		}
+		gf2_reduce(square,modulus);
+		return square;
+	}
+	
+	//x^(exponent*2^doublings) mod modulus, square and multiply from the most significant bit on
+	inline gf2_polynomial gf2_power_of_x_mod(unsigned long long exponent, std::size_t doublings, const gf2_modulus& modulus)
+	{
+		gf2_polynomial result(gf2_words(modulus.degree));
+		result[0]=1;
+		
+		for(auto bit=std::numeric_limits<unsigned long long>::digits;bit-->0;)
+		{
+			result=gf2_square_mod(result,modulus);
+			if((exponent>>bit)&1)
+			{
+				//times x
+				gf2_polynomial shifted(result.size()+1);
+				gf2_add_shifted(shifted,result,1);
+				gf2_reduce(shifted,modulus);
+				result=std::move(shifted);
+			}
+		}
+		
+		for(std::size_t i=0;i<doublings;++i)
+			result=gf2_square_mod(result,modulus);
+		
+		return result;
+	}
 }
 
 template
@@ -31,13 +300,18 @@ template
 class mersenne_twister
 {
 	public:
+	using result_type=T;
+	
+	static constexpr result_type min() noexcept { return 0; }
+	static constexpr result_type max() noexcept { return detail::compute_wbitmask<T,w>(); }
+	
 	constexpr explicit mersenne_twister(T seed) noexcept
 	{
 		auto statep=&std::get<0>(state);
 		statep[0]=seed;
 		for(std::size_t i=1;i<n;++i)
 			statep[i]=(f*((statep[i-1]^(statep[i-1]>>(w-2))))+i)&wbitmask;
-
+		
 		twist();
 	}
 	
@@ -53,35 +327,291 @@ class mersenne_twister
 		auto ret_val=statep[idx];
 		if(++idx==n)
 			twist();
-			
-		ret_val^=(ret_val>>u) & d;
-		ret_val^=(ret_val<<s) & b;
-		ret_val^=(ret_val<<t) & c;
-		ret_val^=(ret_val>>l);
 		
-		return ret_val&wbitmask;
+		return temper(ret_val);
+	}
+	
+	//Fills [first,last) with the next numbers, exactly as calling operator() for each of them would.
+	//At runtime, whole blocks of the state are tempered at once, with SIMD where available.
+	template <typename ITER_T>
+	constexpr void generate(ITER_T first, ITER_T last)
+	{
+		if(ptl::is_constant_evaluated())
+		{
+			for(;first!=last;++first)
+				*first=(*this)();
+			return;
+		}
+		
+		generate_runtime(first,last);
+	}
+	
+	//x^steps modulo the characteristic polynomial of the twister, to be applied with jump. Worth keeping around for repeated jumps of the same distance.
+	class jump_polynomial
+	{
+		friend class mersenne_twister;
+		
+		explicit jump_polynomial(detail::gf2_polynomial coefficients):
+			coefficients_{std::move(coefficients)}
+		{}
+		
+		detail::gf2_polynomial coefficients_;
+	};
+	
+	//for a jump of steps*2^doublings numbers
+	static jump_polynomial make_jump(unsigned long long steps, std::size_t doublings=0)
+	{
+		return jump_polynomial{detail::gf2_power_of_x_mod(steps,doublings,jump_modulus())};
+	}
+	
+	//Advancing the state by J steps is multiplying it by the matrix A^J of the recurrence. With the characteristic polynomial p of A, A^J=g(A) for g=x^J mod p,
+	//as p(A)=0, and g(A) applied to the state is just as many single steps of the recurrence as p has coefficients, evaluated Horner style.
+	void jump(const jump_polynomial& poly) noexcept
+	{
+		sequence_window current;
+		current.words=state;
+		for(std::size_t i=0;i<idx;++i)
+			current.step();
+		
+		sequence_window result;
+		for(auto i=jump_modulus().degree;i-->0;)
+		{
+			result.step();
+			if(detail::gf2_bit(poly.coefficients_,i))
+				result.add(current);
+		}
+		
+		for(std::size_t i=0;i<n;++i)
+			state[i]=result.words[(result.start+i)%n];
+		idx=0;
+	}
+	
+	//Same as calling operator() steps times, if quite a bit faster. Far enough at runtime, by jumping ahead, which takes a few dozen milliseconds.
+	constexpr void discard(unsigned long long steps)
+	{
+		constexpr unsigned long long jump_threshold=1ull<<26;
+		if(!ptl::is_constant_evaluated() && steps>=jump_threshold)
+		{
+			jump(make_jump(steps));
+			return;
+		}
+		
+		while(steps>0)
+		{
+			const auto skipped=std::min<unsigned long long>(steps,n-idx);
+			idx+=skipped;
+			steps-=skipped;
+			if(idx==n)
+				twist();
+		}
+	}
+	
+	//Engines for count workers, the i-th one being a copy of this one advanced by i*2^substream_log2 numbers,
+	//so they are reproducible and will not overlap unless someone draws more than that from one of them.
+	static constexpr std::size_t substream_log2=128;
+	
+	std::vector<mersenne_twister> split(std::size_t count) const
+	{
+		static const auto substream_jump=make_jump(1,substream_log2);
+		
+		std::vector<mersenne_twister> engines;
+		engines.reserve(count);
+		if(count>0)
+			engines.push_back(*this);
+		while(engines.size()<count)
+		{
+			engines.push_back(engines.back());
+			engines.back().jump(substream_jump);
+		}
+		return engines;
 	}
 	
 	private:
 	std::array<T,n> state{};
 	std::size_t idx=0;
 	static constexpr auto wbitmask=detail::compute_wbitmask<T,w>();
-	static constexpr auto lower_mask=(1u<<r)-1;
+	static constexpr auto lower_mask=static_cast<T>((T{1}<<r)-1);
 	static constexpr auto upper_mask=(~lower_mask)&wbitmask;
 	
+	static constexpr T twist_one(T current, T next, T shifted) noexcept
+	{
+		const auto tmp=(current & upper_mask) | (next & lower_mask);
+		return shifted ^ (tmp>>1) ^ ((tmp & 1)!=0?a:T{0});
+	}
+	
+	//the next n words of the sequence, as a ring buffer starting at the one operator() would temper next
+	struct sequence_window
+	{
+		std::array<T,n> words{};
+		std::size_t start=0;
+		
+		void step() noexcept
+		{
+			const auto next=start+1==n?0:start+1;
+			const auto shifted=start+m>=n?start+m-n:start+m;
+			words[start]=twist_one(words[start],words[next],words[shifted]);
+			start=next;
+		}
+		
+		void add(const sequence_window& other) noexcept
+		{
+			const auto offset=(other.start+n-start)%n;
+			for(std::size_t i=0;i<n-offset;++i)
+				words[i]^=other.words[i+offset];
+			for(std::size_t i=n-offset;i<n;++i)
+				words[i]^=other.words[i+offset-n];
+		}
+	};
+	
+	static const detail::gf2_modulus& jump_modulus()
+	{
+		static const detail::gf2_modulus modulus=[]
+		{
+			constexpr auto state_bits=n*w-r;
+			mersenne_twister engine{T{5489}};
+			std::vector<bool> sequence(2*state_bits);
+			for(std::size_t i=0;i<sequence.size();++i)
+				sequence[i]=engine()&1;
+			
+			const auto [connection,length]=detail::gf2_berlekamp_massey(sequence);
+			
+			//x*p, with p(x)=x^length*c(1/x) the reversed connection polynomial
+			detail::gf2_polynomial result(detail::gf2_words(length+2));
+			for(std::size_t i=0;i<=length;++i)
+				if(detail::gf2_bit(connection,i))
+					detail::gf2_flip(result,length+1-i);
+			return detail::gf2_modulus{result,length+1};
+		}();
+		return modulus;
+	}
+	
+	static constexpr T temper(T value) noexcept
+	{
+		value^=(value>>u) & d;
+		value^=(value<<s) & b;
+		value^=(value<<t) & c;
+		value^=(value>>l);
+		return value&wbitmask;
+	}
+	
+	//split where i+1 and i+m wrap around, instead of taking both modulo n every time, which leaves plain loops the compiler can unroll and vectorize
 	constexpr void twist() noexcept
 	{
+		#if defined(__AVX2__) || defined(__SSE2__)
+		if constexpr(sizeof(T)==4 || sizeof(T)==8)
+		{
+			if(!ptl::is_constant_evaluated())
+			{
+				twist_simd();
+				return;
+			}
+		}
+		#endif
+		
 		auto statep=&::std::get<0>(state);
-		for(std::size_t i=0;i<n;++i)
+		for(std::size_t i=0;i<n-m;++i)
+			statep[i]=twist_one(statep[i],statep[i+1],statep[i+m]);
+		for(std::size_t i=n-m;i<n-1;++i)
+			statep[i]=twist_one(statep[i],statep[i+1],statep[i+m-n]);
+		statep[n-1]=twist_one(statep[n-1],statep[0],statep[m-1]);
+		idx=0;
+	}
+	
+	template <typename ITER_T>
+	void generate_runtime(ITER_T first, ITER_T last)
+	{
+		constexpr std::size_t block_size=64;
+		std::array<T,block_size> block;
+		
+		for(;first!=last;)
 		{
-			auto tmp=(statep[i] & upper_mask) + (statep[(i+1)%n] & lower_mask);
-			auto tmp_a=tmp>>1;
-			if(tmp%2!=0)
-				tmp_a^=a;
-			statep[i]=statep[(i+m)%n] ^ tmp_a;
+			std::size_t count=0;
+			for(auto block_last=first;count<std::min(block_size,n-idx) && block_last!=last;++block_last)
+				++count;
+			
+			temper_block(&state[idx],block.data(),count);
+			first=std::copy(block.data(),block.data()+count,first);
+			
+			idx+=count;
+			if(idx==n)
+				twist();
 		}
+	}
+	
+	#if defined(__AVX2__) || defined(__SSE2__)
+	static constexpr std::size_t lanes=sizeof(detail::mt_vector)/sizeof(T);
+	
+	//Same three loops as the scalar version, lanes elements at a time. The second loop reads what the first (and its own earlier iterations) wrote,
+	//but always from at least n-m elements back, far enough for none of that to be inside the vector being computed.
+	void twist_simd() noexcept
+	{
+		static_assert(lanes<n-m && lanes<=m,"Vector too wide for this twister ;_;");
+		
+		const auto upper=detail::mt_broadcast<T>(upper_mask);
+		const auto lower=detail::mt_broadcast<T>(lower_mask);
+		const auto matrix=detail::mt_broadcast<T>(a);
+		
+		auto statep=state.data();
+		const auto step=[&](std::size_t i, std::size_t shifted_idx)
+		{
+			const auto tmp=detail::mt_or(detail::mt_and(detail::mt_load(statep+i),upper),detail::mt_and(detail::mt_load(statep+i+1),lower));
+			const auto matrix_part=detail::mt_and(detail::mt_lowest_bit_mask<T>(tmp),matrix);
+			const auto result=detail::mt_xor(detail::mt_xor(detail::mt_load(statep+shifted_idx),detail::mt_shift_right<T>(tmp,1)),matrix_part);
+			detail::mt_store(statep+i,result);
+		};
+		
+		constexpr std::size_t first_vectors_end=(n-m)/lanes*lanes;
+		constexpr std::size_t second_vectors_end=n-m+(m-1)/lanes*lanes;
+		
+		for(std::size_t i=0;i<first_vectors_end;i+=lanes)
+			step(i,i+m);
+		for(std::size_t i=first_vectors_end;i<n-m;++i)
+			statep[i]=twist_one(statep[i],statep[i+1],statep[i+m]);
+		
+		for(std::size_t i=n-m;i<second_vectors_end;i+=lanes)
+			step(i,i+m-n);
+		for(std::size_t i=second_vectors_end;i<n-1;++i)
+			statep[i]=twist_one(statep[i],statep[i+1],statep[i+m-n]);
+		
+		statep[n-1]=twist_one(statep[n-1],statep[0],statep[m-1]);
 		idx=0;
 	}
+	
+	static void temper_block(const T* source, T* dest, std::size_t count) noexcept
+	{
+		if constexpr(sizeof(T)==4 || sizeof(T)==8)
+		{
+			const auto d_mask=detail::mt_broadcast<T>(d);
+			const auto b_mask=detail::mt_broadcast<T>(b);
+			const auto c_mask=detail::mt_broadcast<T>(c);
+			const auto w_mask=detail::mt_broadcast<T>(wbitmask);
+			
+			std::size_t i=0;
+			for(;i+lanes<=count;i+=lanes)
+			{
+				auto value=detail::mt_load(source+i);
+				value=detail::mt_xor(value,detail::mt_and(detail::mt_shift_right<T>(value,u),d_mask));
+				value=detail::mt_xor(value,detail::mt_and(detail::mt_shift_left<T>(value,s),b_mask));
+				value=detail::mt_xor(value,detail::mt_and(detail::mt_shift_left<T>(value,t),c_mask));
+				value=detail::mt_xor(value,detail::mt_shift_right<T>(value,l));
+				detail::mt_store(dest+i,detail::mt_and(value,w_mask));
+			}
+			for(;i<count;++i)
+				dest[i]=temper(source[i]);
+		}
+		else
+		{
+			for(std::size_t i=0;i<count;++i)
+				dest[i]=temper(source[i]);
+		}
+	}
+	#else
+	static void temper_block(const T* source, T* dest, std::size_t count) noexcept
+	{
+		for(std::size_t i=0;i<count;++i)
+			dest[i]=temper(source[i]);
+	}
+	#endif
 };
 
 using mersenne_twister19937=mersenne_twister<std::uint32_t, 32, 624, 397, 31, 0x9908b0df, 11, 0xffffffff, 7, 0x9d2c5680, 15, 0xefc60000, 18, 1812433253>;
@@ -0,0 +1,348 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_CONSTEXPR_RANDOM_DISTRIBUTIONS_H
+#define PHIL_TEMPLATE_LIBRARY_CONSTEXPR_RANDOM_DISTRIBUTIONS_H
+
+#include <ptl/constexpr_algorithm.hpp>
+
+#include <array>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+/***
+  Constexpr distributions on top of any engine producing full 32 or 64 bit words, like mersenne_twister or the ones in constexpr_random_engines.hpp.
+  Unlike the standard ones, the numbers they produce are fully specified and therefore the same everywhere, at compile time included:
+  bounded integers use Lemire's multiply and shift, with a division only in the rare case that a rejection might be necessary,
+  floating point numbers take the upper 24 (float) or 53 (double) bits of a word, scaled to [0,1), bernoulli compares a word against p*2^64.
+  Their generate fills a whole range at once, drawing the engine's words in blocks through its own generate. The resulting numbers follow the same distribution,
+  but are not the same as those of calling operator() repeatedly, as rejections draw their replacements only after the block.
+  shuffle is a Fisher-Yates shuffle and sample a stable selection sampling, both using the bounded integers.
+***/
+
+namespace ptl
+{
+
+namespace detail
+{
+	template <typename ENGINE_T>
+	constexpr int engine_bits() noexcept
+	{
+		static_assert(ENGINE_T::min()==0 && (ENGINE_T::max()==0xffffffffull || ENGINE_T::max()==0xffffffffffffffffull),"Only engines producing full 32 or 64 bit words are supported ;_;");
+		return ENGINE_T::max()==0xffffffffull?32:64;
+	}
+	
+	//upper bits of wider words, as some engines' lower ones are their weakest
+	template <typename WORD_T, typename ENGINE_T, typename RAW_ITER_T>
+	constexpr WORD_T combine_word(RAW_ITER_T raw) noexcept
+	{
+		constexpr int word_bits=std::numeric_limits<WORD_T>::digits;
+		constexpr int bits=engine_bits<ENGINE_T>();
+		
+		if constexpr(bits==word_bits)
+			return static_cast<WORD_T>(*raw);
+		else if constexpr(bits>word_bits)
+			return static_cast<WORD_T>(static_cast<std::uint64_t>(*raw)>>(bits-word_bits));
+		else
+			return static_cast<WORD_T>((static_cast<std::uint64_t>(raw[0])<<32)|static_cast<std::uint64_t>(raw[1]));
+	}
+	
+	template <typename WORD_T, typename ENGINE_T>
+	constexpr std::size_t raw_per_word=engine_bits<ENGINE_T>()<std::numeric_limits<WORD_T>::digits?2:1;
+	
+	template <typename WORD_T, typename ENGINE_T>
+	constexpr WORD_T random_word(ENGINE_T& engine)
+	{
+		std::array<typename ENGINE_T::result_type,raw_per_word<WORD_T,ENGINE_T>> raw{};
+		for(auto& value: raw)
+			value=engine();
+		return combine_word<WORD_T,ENGINE_T>(raw.data());
+	}
+	
+	template <typename WORD_T>
+	struct wide_product
+	{
+		WORD_T high, low;
+	};
+	
+	constexpr wide_product<std::uint32_t> multiply_wide(std::uint32_t lhs, std::uint32_t rhs) noexcept
+	{
+		const auto product=static_cast<std::uint64_t>(lhs)*rhs;
+		return {static_cast<std::uint32_t>(product>>32),static_cast<std::uint32_t>(product)};
+	}
+	
+	constexpr wide_product<std::uint64_t> multiply_wide(std::uint64_t lhs, std::uint64_t rhs) noexcept
+	{
+	#ifdef __SIZEOF_INT128__
+		__extension__ typedef unsigned __int128 uint128;
+		const auto product=static_cast<uint128>(lhs)*rhs;
+		return {static_cast<std::uint64_t>(product>>64),static_cast<std::uint64_t>(product)};
+	#else
+		const std::uint64_t lhs_low=lhs&0xffffffff, lhs_high=lhs>>32;
+		const std::uint64_t rhs_low=rhs&0xffffffff, rhs_high=rhs>>32;
+		
+		const auto low_low=lhs_low*rhs_low;
+		const auto high_low=lhs_high*rhs_low;
+		const auto low_high=lhs_low*rhs_high;
+		const auto middle=(low_low>>32)+(high_low&0xffffffffull)+low_high;
+		
+		return {lhs_high*rhs_high+(high_low>>32)+(middle>>32),(middle<<32)|(low_low&0xffffffffull)};
+	#endif
+	}
+	
+	//Lemire's nearly divisionless bounded integers in [0,range), with a range of 0 standing in for all of WORD_T
+	template <typename WORD_T, typename ENGINE_T>
+	constexpr WORD_T bounded(WORD_T word, WORD_T range, ENGINE_T& engine)
+	{
+		if(range==0)
+			return word;
+		
+		auto product=multiply_wide(word,range);
+		if(product.low<range)
+		{
+			const auto threshold=static_cast<WORD_T>(static_cast<WORD_T>(-range)%range);
+			while(product.low<threshold)
+				product=multiply_wide(random_word<WORD_T>(engine),range);
+		}
+		return product.high;
+	}
+	
+	template <typename WORD_T, typename ENGINE_T>
+	constexpr WORD_T bounded(WORD_T range, ENGINE_T& engine)
+	{
+		return bounded(random_word<WORD_T>(engine),range,engine);
+	}
+	
+	//a random index below size, with 32 bit words for as long as they suffice
+	template <typename ENGINE_T>
+	constexpr std::uint64_t random_index(std::uint64_t size, ENGINE_T& engine)
+	{
+		if(size<=0xffffffffull)
+			return bounded(static_cast<std::uint32_t>(size),engine);
+		return bounded(size,engine);
+	}
+	
+	//Fills [first,last) with convert(word,engine) for words drawn in blocks with the engine's generate
+	template <typename WORD_T, typename ITER_T, typename ENGINE_T, typename CONVERT_T>
+	constexpr void generate_from_words(ITER_T first, ITER_T last, ENGINE_T& engine, CONVERT_T convert)
+	{
+		constexpr std::size_t block_size=64;
+		constexpr auto raw_per_word=detail::raw_per_word<WORD_T,ENGINE_T>;
+		
+		std::array<typename ENGINE_T::result_type,block_size*raw_per_word> raw{};
+		for(auto remaining=static_cast<std::size_t>(std::distance(first,last));remaining>0;)
+		{
+			const auto count=remaining<block_size?remaining:block_size;
+			engine.generate(raw.data(),raw.data()+count*raw_per_word);
+			
+			for(std::size_t i=0;i<count;++i,++first)
+				*first=convert(combine_word<WORD_T,ENGINE_T>(raw.data()+i*raw_per_word),engine);
+			remaining-=count;
+		}
+	}
+}
+
+template <typename T=int>
+class uniform_int_distribution
+{
+	static_assert(std::is_integral_v<T> && !std::is_same_v<T,bool>,"uniform_int_distribution needs an integral type ;_;");
+	
+	public:
+	using result_type=T;
+	
+	constexpr uniform_int_distribution():
+		uniform_int_distribution{0,std::numeric_limits<T>::max()}
+	{}
+	
+	constexpr uniform_int_distribution(T a, T b):
+		a_{a},
+		b_{b},
+		range{static_cast<word_type>(static_cast<word_type>(static_cast<word_type>(b)-static_cast<word_type>(a))+1)}
+	{
+		if(b<a)
+			throw std::invalid_argument{"uniform_int_distribution needs a<=b ;_;"};
+	}
+	
+	template <typename ENGINE_T>
+	constexpr T operator()(ENGINE_T& engine) const
+	{
+		return from_offset(detail::bounded(range,engine));
+	}
+	
+	template <typename ITER_T, typename ENGINE_T>
+	constexpr void generate(ITER_T first, ITER_T last, ENGINE_T& engine) const
+	{
+		detail::generate_from_words<word_type>(first,last,engine,[this](word_type word, ENGINE_T& redraw)
+		{
+			return from_offset(detail::bounded(word,range,redraw));
+		});
+	}
+	
+	constexpr T a() const noexcept { return a_; }
+	constexpr T b() const noexcept { return b_; }
+	constexpr T min() const noexcept { return a_; }
+	constexpr T max() const noexcept { return b_; }
+	
+	friend constexpr bool operator==(const uniform_int_distribution& lhs, const uniform_int_distribution& rhs) noexcept { return lhs.a_==rhs.a_ && lhs.b_==rhs.b_; }
+	friend constexpr bool operator!=(const uniform_int_distribution& lhs, const uniform_int_distribution& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	//smaller types still use 32 bit words, as that is what the engines produce
+	using word_type=std::conditional_t<(sizeof(T)<=4),std::uint32_t,std::uint64_t>;
+	
+	constexpr T from_offset(word_type offset) const noexcept
+	{
+		return static_cast<T>(static_cast<word_type>(static_cast<word_type>(a_)+offset));
+	}
+	
+	T a_, b_;
+	word_type range;
+};
+
+//Uniform in [0,1), with as many random bits as fit into the mantissa. Long doubles get the 53 bits of a double.
+template <typename T, typename ENGINE_T>
+constexpr T generate_canonical(ENGINE_T& engine)
+{
+	static_assert(std::is_floating_point_v<T>,"generate_canonical needs a floating point type ;_;");
+	
+	if constexpr(std::is_same_v<T,float>)
+		return static_cast<float>(detail::random_word<std::uint32_t>(engine)>>8)*0x1.0p-24f;
+	else
+		return static_cast<T>(static_cast<double>(detail::random_word<std::uint64_t>(engine)>>11)*0x1.0p-53);
+}
+
+template <typename T=double>
+class uniform_real_distribution
+{
+	static_assert(std::is_floating_point_v<T>,"uniform_real_distribution needs a floating point type ;_;");
+	
+	public:
+	using result_type=T;
+	
+	constexpr uniform_real_distribution():
+		uniform_real_distribution{0,1}
+	{}
+	
+	constexpr uniform_real_distribution(T a, T b):
+		a_{a},
+		b_{b}
+	{
+		if(!(a<=b))
+			throw std::invalid_argument{"uniform_real_distribution needs a<=b ;_;"};
+	}
+	
+	template <typename ENGINE_T>
+	constexpr T operator()(ENGINE_T& engine) const
+	{
+		return scale(generate_canonical<T>(engine));
+	}
+	
+	template <typename ITER_T, typename ENGINE_T>
+	constexpr void generate(ITER_T first, ITER_T last, ENGINE_T& engine) const
+	{
+		if constexpr(std::is_same_v<T,float>)
+			detail::generate_from_words<std::uint32_t>(first,last,engine,[this](std::uint32_t word, ENGINE_T&) { return scale(static_cast<float>(word>>8)*0x1.0p-24f); });
+		else
+			detail::generate_from_words<std::uint64_t>(first,last,engine,[this](std::uint64_t word, ENGINE_T&) { return scale(static_cast<T>(static_cast<double>(word>>11)*0x1.0p-53)); });
+	}
+	
+	constexpr T a() const noexcept { return a_; }
+	constexpr T b() const noexcept { return b_; }
+	constexpr T min() const noexcept { return a_; }
+	constexpr T max() const noexcept { return b_; }
+	
+	friend constexpr bool operator==(const uniform_real_distribution& lhs, const uniform_real_distribution& rhs) noexcept { return lhs.a_==rhs.a_ && lhs.b_==rhs.b_; }
+	friend constexpr bool operator!=(const uniform_real_distribution& lhs, const uniform_real_distribution& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	constexpr T scale(T canonical) const noexcept
+	{
+		return a_+(b_-a_)*canonical;
+	}
+	
+	T a_, b_;
+};
+
+class bernoulli_distribution
+{
+	public:
+	using result_type=bool;
+	
+	constexpr bernoulli_distribution():
+		bernoulli_distribution{0.5}
+	{}
+	
+	constexpr explicit bernoulli_distribution(double p):
+		p_{p},
+		threshold{p<1?static_cast<std::uint64_t>(p*0x1.0p64):0},
+		certain{p>=1}
+	{
+		if(!(p>=0 && p<=1))
+			throw std::invalid_argument{"bernoulli_distribution needs a probability between 0 and 1 ;_;"};
+	}
+	
+	template <typename ENGINE_T>
+	constexpr bool operator()(ENGINE_T& engine) const
+	{
+		return from_word(detail::random_word<std::uint64_t>(engine));
+	}
+	
+	template <typename ITER_T, typename ENGINE_T>
+	constexpr void generate(ITER_T first, ITER_T last, ENGINE_T& engine) const
+	{
+		detail::generate_from_words<std::uint64_t>(first,last,engine,[this](std::uint64_t word, ENGINE_T&) { return from_word(word); });
+	}
+	
+	constexpr double p() const noexcept { return p_; }
+	constexpr bool min() const noexcept { return false; }
+	constexpr bool max() const noexcept { return true; }
+	
+	friend constexpr bool operator==(const bernoulli_distribution& lhs, const bernoulli_distribution& rhs) noexcept { return lhs.p_==rhs.p_; }
+	friend constexpr bool operator!=(const bernoulli_distribution& lhs, const bernoulli_distribution& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	constexpr bool from_word(std::uint64_t word) const noexcept
+	{
+		return certain || word<threshold;
+	}
+	
+	double p_;
+	std::uint64_t threshold;
+	bool certain;
+};
+
+template <typename ITER_T, typename ENGINE_T>
+constexpr void shuffle(ITER_T first, ITER_T last, ENGINE_T& engine)
+{
+	static_assert(std::is_convertible_v<typename std::iterator_traits<ITER_T>::iterator_category,std::random_access_iterator_tag>,"shuffle requires random access iterators ;_;");
+	
+	const auto size=static_cast<std::uint64_t>(last-first);
+	for(auto i=size;i>1;--i)
+	{
+		::ptl::constexpr_algorithm::swap(first[i-1],first[detail::random_index(i,engine)]);
+	}
+}
+
+//Picks count elements, each subset equally likely, and copies them to out in their original order. Returns the end of the copied elements.
+template <typename ITER_T, typename OUTPUT_ITER_T, typename ENGINE_T>
+constexpr OUTPUT_ITER_T sample(ITER_T first, ITER_T last, OUTPUT_ITER_T out, std::size_t count, ENGINE_T& engine)
+{
+	auto remaining=static_cast<std::uint64_t>(std::distance(first,last));
+	for(std::uint64_t needed=count;needed>0 && remaining>0;++first,--remaining)
+	{
+		if(detail::random_index(remaining,engine)<needed)
+		{
+			*out=*first;
+			++out;
+			--needed;
+		}
+	}
+	return out;
+}
+
+} //end namespace ptl
+
+#endif
@@ -0,0 +1,350 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_CONSTEXPR_RANDOM_ENGINES_H
+#define PHIL_TEMPLATE_LIBRARY_CONSTEXPR_RANDOM_ENGINES_H
+
+#include <array>
+#include <limits>
+
+#include <cstddef>
+#include <cstdint>
+
+/***
+  Small, fast, constexpr random engines for everything the 2.5KB state of the mersenne twister is overkill for.
+  All of them satisfy UniformRandomBitGenerator and follow mersenne_twister's interface: seeded with a single integer,
+  operator() for the next number, generate to fill a range and discard to skip ahead, plus jump and long_jump where their authors defined them.
+  Outputs match the reference implementations for the same state, seeding from a single integer is ours (with splitmix64, as recommended for xoshiro).
+  pcg64 needs a 128 bit integer type, which only gcc and clang provide.
+***/
+
+namespace ptl
+{
+
+namespace detail
+{
+	constexpr std::uint64_t rotl(std::uint64_t value, int shift) noexcept
+	{
+		return (value<<shift)|(value>>(64-shift));
+	}
+	
+	constexpr std::uint32_t rotr(std::uint32_t value, unsigned int shift) noexcept
+	{
+		return (value>>shift)|(value<<((32-shift)&31));
+	}
+	
+	constexpr std::uint64_t rotr(std::uint64_t value, unsigned int shift) noexcept
+	{
+		return (value>>shift)|(value<<((64-shift)&63));
+	}
+	
+	//std::array's comparisons are not constexpr before C++20
+	template <std::size_t NUM>
+	constexpr bool equal_state(const std::array<std::uint64_t,NUM>& lhs, const std::array<std::uint64_t,NUM>& rhs) noexcept
+	{
+		for(std::size_t i=0;i<NUM;++i)
+			if(lhs[i]!=rhs[i])
+				return false;
+		return true;
+	}
+	
+	//what all the engines share, for CHILD_T to inherit from
+	template <typename CHILD_T, typename RESULT_T>
+	class random_bit_generator
+	{
+		public:
+		using result_type=RESULT_T;
+		
+		static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+		static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+		
+		template <typename ITER_T>
+		constexpr void generate(ITER_T first, ITER_T last)
+		{
+			auto& self=static_cast<CHILD_T&>(*this);
+			for(;first!=last;++first)
+				*first=self();
+		}
+	};
+}
+
+//Vigna's splitmix64, a counter run through a mixing function. Tiny and fast, but meant for seeding other engines rather than for heavy use itself.
+class splitmix64: public detail::random_bit_generator<splitmix64,std::uint64_t>
+{
+	public:
+	constexpr explicit splitmix64(std::uint64_t seed) noexcept:
+		state{seed}
+	{}
+	
+	constexpr std::uint64_t operator()() noexcept
+	{
+		state+=increment;
+		auto z=state;
+		z=(z^(z>>30))*0xbf58476d1ce4e5b9ull;
+		z=(z^(z>>27))*0x94d049bb133111ebull;
+		return z^(z>>31);
+	}
+	
+	constexpr void discard(unsigned long long steps) noexcept
+	{
+		state+=increment*steps;
+	}
+	
+	friend constexpr bool operator==(const splitmix64& lhs, const splitmix64& rhs) noexcept { return lhs.state==rhs.state; }
+	friend constexpr bool operator!=(const splitmix64& lhs, const splitmix64& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	static constexpr std::uint64_t increment=0x9e3779b97f4a7c15ull;
+	std::uint64_t state;
+};
+
+namespace detail
+{
+	//The xo(ro)shiro engines are linear over GF(2), so jumping ahead is applying the polynomial x^distance mod their characteristic polynomial:
+	//sum up the states at each of its set coefficients, one step at a time.
+	template <typename ENGINE_T, std::size_t NUM>
+	constexpr void xoshiro_jump(ENGINE_T& engine, std::array<std::uint64_t,NUM>& state, const std::array<std::uint64_t,NUM>& polynomial) noexcept
+	{
+		std::array<std::uint64_t,NUM> sum{};
+		for(auto word: polynomial)
+		{
+			for(int bit=0;bit<64;++bit)
+			{
+				if((word>>bit)&1)
+					for(std::size_t i=0;i<NUM;++i)
+						sum[i]^=state[i];
+				engine();
+			}
+		}
+		state=sum;
+	}
+	
+	template <std::size_t NUM>
+	constexpr std::array<std::uint64_t,NUM> splitmix_state(std::uint64_t seed) noexcept
+	{
+		splitmix64 seeder{seed};
+		std::array<std::uint64_t,NUM> state{};
+		for(auto& word: state)
+			word=seeder();
+		return state;
+	}
+}
+
+//Blackman and Vigna's all-purpose xoshiro256**, 256 bits of state and a period of 2^256-1.
+class xoshiro256starstar: public detail::random_bit_generator<xoshiro256starstar,std::uint64_t>
+{
+	public:
+	constexpr explicit xoshiro256starstar(std::uint64_t seed) noexcept:
+		state{detail::splitmix_state<4>(seed)}
+	{}
+	
+	//must not be all zero
+	constexpr explicit xoshiro256starstar(const std::array<std::uint64_t,4>& state) noexcept:
+		state{state}
+	{}
+	
+	constexpr std::uint64_t operator()() noexcept
+	{
+		const auto result=detail::rotl(state[1]*5,7)*9;
+		const auto t=state[1]<<17;
+		
+		state[2]^=state[0];
+		state[3]^=state[1];
+		state[1]^=state[2];
+		state[0]^=state[3];
+		state[2]^=t;
+		state[3]=detail::rotl(state[3],45);
+		
+		return result;
+	}
+	
+	constexpr void discard(unsigned long long steps) noexcept
+	{
+		for(;steps>0;--steps)
+			(*this)();
+	}
+	
+	//2^128 steps ahead, for up to 2^128 non-overlapping sequences
+	constexpr void jump() noexcept
+	{
+		detail::xoshiro_jump(*this,state,{{0x180ec6d33cfd0abaull,0xd5a61266f0c9392cull,0xa9582618e03fc9aaull,0x39abdc4529b1661cull}});
+	}
+	
+	//2^192 steps ahead, for up to 2^64 starting points to jump() from
+	constexpr void long_jump() noexcept
+	{
+		detail::xoshiro_jump(*this,state,{{0x76e15d3efefdcbbfull,0xc5004e441c522fb3ull,0x77710069854ee241ull,0x39109bb02acbe635ull}});
+	}
+	
+	friend constexpr bool operator==(const xoshiro256starstar& lhs, const xoshiro256starstar& rhs) noexcept { return detail::equal_state(lhs.state,rhs.state); }
+	friend constexpr bool operator!=(const xoshiro256starstar& lhs, const xoshiro256starstar& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	std::array<std::uint64_t,4> state;
+};
+
+//Blackman and Vigna's xoroshiro128++, with only 128 bits of state for when there are lots of engines. Period 2^128-1.
+class xoroshiro128plusplus: public detail::random_bit_generator<xoroshiro128plusplus,std::uint64_t>
+{
+	public:
+	constexpr explicit xoroshiro128plusplus(std::uint64_t seed) noexcept:
+		state{detail::splitmix_state<2>(seed)}
+	{}
+	
+	//must not be all zero
+	constexpr explicit xoroshiro128plusplus(const std::array<std::uint64_t,2>& state) noexcept:
+		state{state}
+	{}
+	
+	constexpr std::uint64_t operator()() noexcept
+	{
+		const auto s0=state[0];
+		auto s1=state[1];
+		const auto result=detail::rotl(s0+s1,17)+s0;
+		
+		s1^=s0;
+		state[0]=detail::rotl(s0,49)^s1^(s1<<21);
+		state[1]=detail::rotl(s1,28);
+		
+		return result;
+	}
+	
+	constexpr void discard(unsigned long long steps) noexcept
+	{
+		for(;steps>0;--steps)
+			(*this)();
+	}
+	
+	//2^64 steps ahead, for up to 2^64 non-overlapping sequences
+	constexpr void jump() noexcept
+	{
+		detail::xoshiro_jump(*this,state,{{0x2bd7a6a6e99c2ddcull,0x0992ccaf6a6fca05ull}});
+	}
+	
+	//2^96 steps ahead, for up to 2^32 starting points to jump() from
+	constexpr void long_jump() noexcept
+	{
+		detail::xoshiro_jump(*this,state,{{0x360fd5f2cf8d5d99ull,0x9c6e6877736c46e3ull}});
+	}
+	
+	friend constexpr bool operator==(const xoroshiro128plusplus& lhs, const xoroshiro128plusplus& rhs) noexcept { return detail::equal_state(lhs.state,rhs.state); }
+	friend constexpr bool operator!=(const xoroshiro128plusplus& lhs, const xoroshiro128plusplus& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	std::array<std::uint64_t,2> state;
+};
+
+namespace detail
+{
+	//Brown's algorithm: the affine map of steps LCG steps, by squaring the map of a single one
+	template <typename T>
+	constexpr T lcg_advance(T state, T multiplier, T increment, unsigned long long steps) noexcept
+	{
+		T total_multiplier=1;
+		T total_increment=0;
+		for(;steps>0;steps>>=1)
+		{
+			if(steps&1)
+			{
+				total_multiplier*=multiplier;
+				total_increment=total_increment*multiplier+increment;
+			}
+			increment=(multiplier+1)*increment;
+			multiplier*=multiplier;
+		}
+		return total_multiplier*state+total_increment;
+	}
+}
+
+//O'Neill's pcg32 (XSH-RR on a 64 bit LCG), with a selectable stream. Same as pcg32_srandom_r(seed,stream) of the reference C implementation
+//and, with the default stream, as pcg32 of the reference C++ implementation.
+class pcg32: public detail::random_bit_generator<pcg32,std::uint32_t>
+{
+	public:
+	constexpr explicit pcg32(std::uint64_t seed, std::uint64_t stream=0x14057b7ef767814full>>1) noexcept:
+		state{0},
+		increment{(stream<<1)|1}
+	{
+		step();
+		state+=seed;
+		step();
+	}
+	
+	constexpr std::uint32_t operator()() noexcept
+	{
+		const auto old=state;
+		step();
+		return detail::rotr(static_cast<std::uint32_t>(((old>>18)^old)>>27),static_cast<unsigned int>(old>>59));
+	}
+	
+	constexpr void discard(unsigned long long steps) noexcept
+	{
+		state=detail::lcg_advance(state,multiplier,increment,steps);
+	}
+	
+	friend constexpr bool operator==(const pcg32& lhs, const pcg32& rhs) noexcept { return lhs.state==rhs.state && lhs.increment==rhs.increment; }
+	friend constexpr bool operator!=(const pcg32& lhs, const pcg32& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	static constexpr std::uint64_t multiplier=6364136223846793005ull;
+	std::uint64_t state;
+	std::uint64_t increment;
+	
+	constexpr void step() noexcept
+	{
+		state=state*multiplier+increment;
+	}
+};
+
+#ifdef __SIZEOF_INT128__
+namespace detail
+{
+	__extension__ typedef unsigned __int128 uint128;
+	
+	constexpr uint128 make_uint128(std::uint64_t high, std::uint64_t low) noexcept
+	{
+		return (static_cast<uint128>(high)<<64)|low;
+	}
+}
+
+//O'Neill's pcg64 (XSL-RR on a 128 bit LCG), with a selectable stream. Same as pcg64 of the reference C++ implementation.
+class pcg64: public detail::random_bit_generator<pcg64,std::uint64_t>
+{
+	public:
+	using state_type=detail::uint128;
+	
+	constexpr explicit pcg64(state_type seed, state_type stream=detail::make_uint128(0x5851f42d4c957f2dull,0x14057b7ef767814full)>>1) noexcept:
+		state{0},
+		increment{(stream<<1)|1}
+	{
+		step();
+		state+=seed;
+		step();
+	}
+	
+	constexpr std::uint64_t operator()() noexcept
+	{
+		step();
+		return detail::rotr(static_cast<std::uint64_t>(state>>64)^static_cast<std::uint64_t>(state),static_cast<unsigned int>(state>>122));
+	}
+	
+	constexpr void discard(unsigned long long steps) noexcept
+	{
+		state=detail::lcg_advance(state,multiplier,increment,steps);
+	}
+	
+	friend constexpr bool operator==(const pcg64& lhs, const pcg64& rhs) noexcept { return lhs.state==rhs.state && lhs.increment==rhs.increment; }
+	friend constexpr bool operator!=(const pcg64& lhs, const pcg64& rhs) noexcept { return !(lhs==rhs); }
+	
+	private:
+	static constexpr state_type multiplier=detail::make_uint128(2549297995355413924ull,4865540595714422341ull);
+	state_type state;
+	state_type increment;
+	
+	constexpr void step() noexcept
+	{
+		state=state*multiplier+increment;
+	}
+};
+#endif
+
+} //end namespace ptl
+
+#endif
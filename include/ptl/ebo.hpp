@@ -24,8 +24,8 @@ namespace ptl
 			value(std::forward<ARGS_T>(args)...)
 		{}
 		
-		T& get_ebo_base(typelist<T>) { return value; }
-		const T& get_ebo_base(typelist<T>) const { return value; }
+		constexpr T& get_ebo_base(typelist<T>) { return value; }
+		constexpr const T& get_ebo_base(typelist<T>) const { return value; }
 		
 		private:
 		T value;
@@ -41,8 +41,8 @@ namespace ptl
 			T(std::forward<ARGS_T>(args)...)
 		{}
 		
-		T& get_ebo_base(typelist<T>) { return *this; }
-		const T& get_ebo_base(typelist<T>) const { return *this; }
+		constexpr T& get_ebo_base(typelist<T>) { return *this; }
+		constexpr const T& get_ebo_base(typelist<T>) const { return *this; }
 	};
 	
 	template <bool default_constructible, typename...> class ebo_bases_impl;
@@ -0,0 +1,288 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_EYTZINGER_FLATMAP_H
+#define PHIL_TEMPLATE_LIBRARY_EYTZINGER_FLATMAP_H
+
+#include <ptl/bit.hpp>
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/ebo.hpp>
+#include <ptl/prefetch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+/***
+  An immutable alternative to fixed_flatmap. Instead of plainly sorted, the elements are stored in the order of a breadth first
+  traversal of the implicit binary search tree over them (Eytzinger layout), i.e. the children of the element at (1-based) index k are at 2k and 2k+1.
+  The first few levels of the tree share a handful of cache lines, the search loop runs the same number of iterations for every key
+  and chooses the next index with arithmetic instead of a branch. As all of the next four levels of the path are contiguous in memory,
+  we can also prefetch them well before we need them.
+  Iteration is still in key order, it just takes a few more steps to walk the implicit tree.
+***/
+
+namespace ptl
+{
+	namespace detail
+	{
+		template <typename VALUE_T, std::size_t NUM>
+		class eytzinger_iterator
+		{
+			public:
+			using iterator_category	=	std::bidirectional_iterator_tag;
+			using difference_type	=	std::ptrdiff_t;
+			using value_type		=	std::remove_const_t<VALUE_T>;
+			using reference			=	VALUE_T&;
+			using pointer			=	VALUE_T*;
+			
+			constexpr eytzinger_iterator() = default;
+			
+			//idx is 1-based, 0 is one past the end
+			constexpr eytzinger_iterator(VALUE_T* data, std::size_t idx):
+				data_{data},
+				idx_{idx}
+			{}
+			
+			template <typename OTHER_T, typename = std::enable_if_t<std::is_convertible_v<OTHER_T*,VALUE_T*>>>
+			constexpr eytzinger_iterator(const eytzinger_iterator<OTHER_T,NUM>& other):
+				data_{other.base()},
+				idx_{other.index()}
+			{}
+			
+			constexpr VALUE_T* base() const noexcept { return data_; }
+			constexpr std::size_t index() const noexcept { return idx_; }
+			
+			constexpr reference operator*() const { return data_[idx_-1]; }
+			constexpr pointer operator->() const { return &data_[idx_-1]; }
+			
+			//in order successor: the leftmost element of the right subtree if there is one,
+			//otherwise the first ancestor we reach from its left subtree, i.e. drop all trailing 1 bits and one more
+			constexpr eytzinger_iterator& operator++() noexcept
+			{
+				if(2*idx_+1<=NUM)
+				{
+					idx_=2*idx_+1;
+					while(2*idx_<=NUM)
+						idx_*=2;
+				}
+				else
+					idx_>>=ptl::countr_zero(~idx_)+1;
+				
+				return *this;
+			}
+			
+			//mirror image of the above, with end() being the predecessor of the root's rightmost descendant
+			constexpr eytzinger_iterator& operator--() noexcept
+			{
+				if(idx_==0 || 2*idx_<=NUM)
+				{
+					idx_=idx_==0?1:2*idx_;
+					while(2*idx_+1<=NUM)
+						idx_=2*idx_+1;
+				}
+				else
+					idx_>>=ptl::countr_zero(idx_)+1;
+				
+				return *this;
+			}
+			
+			constexpr eytzinger_iterator operator++(int) noexcept { auto ret_val=*this; ++*this; return ret_val; }
+			constexpr eytzinger_iterator operator--(int) noexcept { auto ret_val=*this; --*this; return ret_val; }
+			
+			friend constexpr bool operator==(const eytzinger_iterator& lhs, const eytzinger_iterator& rhs) noexcept { return lhs.idx_==rhs.idx_; }
+			friend constexpr bool operator!=(const eytzinger_iterator& lhs, const eytzinger_iterator& rhs) noexcept { return !(lhs==rhs); }
+			
+			private:
+			VALUE_T* data_=nullptr;
+			std::size_t idx_=0;
+		};
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>>
+	class fixed_eytzinger_flatmap
+	{
+		public:
+		using key_type					=	KEY_T;
+		using mapped_type				=	MAPPED_T;
+		using value_type				=	std::pair<KEY_T,MAPPED_T>;
+		using size_type					=	std::size_t;
+		using difference_type			=	std::ptrdiff_t;
+		using key_compare				=	COMPARE_T;
+		
+		using reference					=	value_type&;
+		using const_reference			=	const value_type&;
+		
+		using iterator					=	detail::eytzinger_iterator<value_type,NUM>;
+		using const_iterator			=	detail::eytzinger_iterator<const value_type,NUM>;
+		using reverse_iterator			=	std::reverse_iterator<iterator>;
+		using const_reverse_iterator	=	std::reverse_iterator<const_iterator>;
+		
+		//takes elements already sorted by key and without duplicates, make_fixed_eytzinger_flatmap below takes care of that for arbitrary input
+		constexpr fixed_eytzinger_flatmap(const COMPARE_T& comp, const std::array<value_type,NUM>& sorted):
+			data_{comp}
+		{
+			std::size_t next=0;
+			fill(sorted,next,1);
+		}
+		
+		constexpr auto begin() noexcept { return iterator{data(),leftmost()}; }
+		constexpr auto begin() const noexcept { return const_iterator{data(),leftmost()}; }
+		constexpr auto end() noexcept { return iterator{data(),0}; }
+		constexpr auto end() const noexcept { return const_iterator{data(),0}; }
+		
+		constexpr auto rbegin() noexcept { return reverse_iterator{end()}; }
+		constexpr auto rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		constexpr auto rend() noexcept { return reverse_iterator{begin()}; }
+		constexpr auto rend() const noexcept { return const_reverse_iterator{begin()}; }
+		
+		constexpr auto cbegin() const noexcept { return begin(); }
+		constexpr auto cend() const noexcept { return end(); }
+		constexpr auto crbegin() const noexcept { return rbegin(); }
+		constexpr auto crend() const noexcept { return rend(); }
+		
+		constexpr auto empty() const noexcept { return NUM==0; }
+		constexpr auto size() const noexcept { return NUM; }
+		
+		constexpr auto find(const key_type& key)
+		{
+			return iterator{data(),find_index(key)};
+		}
+		
+		constexpr auto find(const key_type& key) const
+		{
+			return const_iterator{data(),find_index(key)};
+		}
+		
+		constexpr auto lower_bound(const key_type& key)
+		{
+			return iterator{data(),lower_bound_index(key)};
+		}
+		
+		constexpr auto lower_bound(const key_type& key) const
+		{
+			return const_iterator{data(),lower_bound_index(key)};
+		}
+		
+		constexpr auto& operator[](const key_type &key)
+		{
+			return access_impl(*this,key);
+		}
+		
+		constexpr const auto& operator[](const key_type &key) const
+		{
+			return access_impl(*this,key);
+		}
+		
+		constexpr key_compare key_comp() const { return data_.get_ebo_base(typelist<COMPARE_T>{}); }
+		
+		private:
+		struct member_data: ebo_base<COMPARE_T>
+		{
+			public:
+			constexpr member_data(const COMPARE_T& comp):
+				ebo_base<COMPARE_T>{comp}
+			{}
+			
+			std::array<value_type,NUM> storage{};
+		} data_;
+		
+		constexpr value_type* data() noexcept { return data_.storage.data(); }
+		constexpr const value_type* data() const noexcept { return data_.storage.data(); }
+		
+		//in order traversal of the implicit tree, handing out the sorted elements one after another
+		constexpr void fill(const std::array<value_type,NUM>& sorted, std::size_t& next, std::size_t idx)
+		{
+			if(idx>NUM)
+				return;
+			
+			fill(sorted,next,2*idx);
+			//std::pair's assignment is not constexpr before C++20
+			data_.storage[idx-1].first=sorted[next].first;
+			data_.storage[idx-1].second=sorted[next].second;
+			++next;
+			fill(sorted,next,2*idx+1);
+		}
+		
+		constexpr static std::size_t leftmost() noexcept
+		{
+			if constexpr(NUM==0)
+				return 0;
+			
+			std::size_t idx=1;
+			while(2*idx<=NUM)
+				idx*=2;
+			return idx;
+		}
+		
+		//Descend until we fall off the tree, going right whenever the current element is smaller than the key.
+		//The bits of idx now spell out the path taken. The lower bound is where we last went left,
+		//so we drop the trailing right turns (1 bits) and the final left one. If we never went left, we end up at 0, i.e. end().
+		constexpr std::size_t lower_bound_index(const key_type& key) const
+		{
+			//index 16*idx is the leftmost of idx's descendants four levels down, which are all stored next to each other.
+			//Clamping keeps the address valid without having to branch on it.
+			constexpr std::size_t prefetch_distance=16;
+			
+			std::size_t idx=1;
+			while(idx<=NUM)
+			{
+				ptl::prefetch(data()+std::min(prefetch_distance*idx,NUM)-1);
+				idx=2*idx+static_cast<std::size_t>(key_comp()(data()[idx-1].first,key));
+			}
+			return idx>>(ptl::countr_zero(~idx)+1);
+		}
+		
+		constexpr std::size_t find_index(const key_type& key) const
+		{
+			auto idx=lower_bound_index(key);
+			if(idx==0 || key_comp()(key,data()[idx-1].first))
+				return 0;
+			return idx;
+		}
+		
+		template <typename const_deduced_self>
+		constexpr static auto& access_impl(const_deduced_self& self, const key_type& key)
+		{
+			auto idx=self.find_index(key);
+			if(idx==0)
+				throw std::out_of_range{"Tried to access nonexistent element with operator[] on an immutable map..."};
+			return self.data()[idx-1].second;
+		}
+	};
+	
+	namespace detail
+	{
+		template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T, std::size_t ...IDX>
+		constexpr auto make_fixed_eytzinger_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM], std::index_sequence<IDX...>)
+		{
+			std::array<std::pair<KEY_T,MAPPED_T>,NUM> arr{{elements[IDX]...}};
+			
+			const auto compare_first = [&](const auto& lhs, const auto& rhs)
+			{
+				return compare(lhs.first,rhs.first);
+			};
+			
+			ptl::constexpr_algorithm::sort(std::begin(arr),std::end(arr),compare_first);
+			return ptl::fixed_eytzinger_flatmap<KEY_T,MAPPED_T,NUM,COMPARE_T>{compare,arr};
+		}
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>>
+	constexpr auto make_fixed_eytzinger_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_eytzinger_flatmap<KEY_T,MAPPED_T,NUM,COMPARE_T>(compare,elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM>
+	constexpr auto make_fixed_eytzinger_flatmap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_eytzinger_flatmap<KEY_T,MAPPED_T,NUM,std::less<KEY_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+	}
+
+} //end namespace ptl
+
+#endif
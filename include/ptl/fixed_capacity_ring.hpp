@@ -0,0 +1,237 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_FIXED_CAPACITY_RING_H
+#define PHIL_TEMPLATE_LIBRARY_FIXED_CAPACITY_RING_H
+
+#include <ptl/fixed_capacity_vector.hpp>
+#include <ptl/uint_bits.hpp>
+
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+namespace ptl
+{
+	namespace detail
+	{
+		//Positions are counted freely and only masked when indexing, so a full ring is distinguishable from an empty one.
+		//The index type holds twice the capacity, its wrap around is harmless as long as the capacity is a power of two.
+		template <std::size_t CAPACITY>
+		struct ring_indices
+		{
+			static_assert(CAPACITY>0 && (CAPACITY&(CAPACITY-1))==0,"Ring capacities have to be powers of two ;_;");
+			
+			using index_type=ptl::uint_for_t<CAPACITY*2-1>;
+			static constexpr std::size_t mask=CAPACITY-1;
+			
+			static constexpr index_type distance(index_type from, index_type to) noexcept { return static_cast<index_type>(to-from); }
+			static constexpr index_type advance(index_type pos, std::size_t count) noexcept { return static_cast<index_type>(pos+count); }
+			static constexpr std::size_t slot(index_type pos) noexcept { return pos&mask; }
+		};
+		
+		template <typename RING_T, typename VALUE_T>
+		class ring_iterator
+		{
+			public:
+			using iterator_category	=	std::random_access_iterator_tag;
+			using value_type		=	std::remove_const_t<VALUE_T>;
+			using difference_type	=	std::ptrdiff_t;
+			using pointer			=	VALUE_T*;
+			using reference			=	VALUE_T&;
+			
+			ring_iterator() noexcept = default;
+			ring_iterator(RING_T* ring, std::size_t offset) noexcept:
+				ring_{ring},
+				offset_{offset}
+			{}
+			
+			//iterator to const_iterator
+			template <typename OTHER_RING_T, typename OTHER_VALUE_T, typename = std::enable_if_t<std::is_convertible_v<OTHER_VALUE_T*,VALUE_T*>>>
+			ring_iterator(const ring_iterator<OTHER_RING_T,OTHER_VALUE_T>& other) noexcept:
+				ring_{other.ring_},
+				offset_{other.offset_}
+			{}
+			
+			reference operator*() const noexcept { return (*ring_)[offset_]; }
+			pointer operator->() const noexcept { return &**this; }
+			reference operator[](difference_type n) const noexcept { return (*ring_)[offset_+n]; }
+			
+			ring_iterator& operator++() noexcept { ++offset_; return *this; }
+			ring_iterator operator++(int) noexcept { auto old=*this; ++offset_; return old; }
+			ring_iterator& operator--() noexcept { --offset_; return *this; }
+			ring_iterator operator--(int) noexcept { auto old=*this; --offset_; return old; }
+			
+			ring_iterator& operator+=(difference_type n) noexcept { offset_+=n; return *this; }
+			ring_iterator& operator-=(difference_type n) noexcept { offset_-=n; return *this; }
+			
+			friend ring_iterator operator+(ring_iterator it, difference_type n) noexcept { return it+=n; }
+			friend ring_iterator operator+(difference_type n, ring_iterator it) noexcept { return it+=n; }
+			friend ring_iterator operator-(ring_iterator it, difference_type n) noexcept { return it-=n; }
+			friend difference_type operator-(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return static_cast<difference_type>(lhs.offset_)-static_cast<difference_type>(rhs.offset_); }
+			
+			friend bool operator==(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return lhs.offset_==rhs.offset_; }
+			friend bool operator!=(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return lhs.offset_!=rhs.offset_; }
+			friend bool operator<(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return lhs.offset_<rhs.offset_; }
+			friend bool operator>(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return rhs<lhs; }
+			friend bool operator<=(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return !(rhs<lhs); }
+			friend bool operator>=(const ring_iterator& lhs, const ring_iterator& rhs) noexcept { return !(lhs<rhs); }
+			
+			private:
+			template <typename, typename> friend class ring_iterator;
+			
+			RING_T* ring_=nullptr;
+			std::size_t offset_=0;
+		};
+	}
+	
+	//A double ended queue of fixed, power of two capacity in the same uninitialized storage as fixed_capacity_vector, wrapping around with a mask.
+	//Like with fixed_capacity_vector, pushing into a full ring is up to you to avoid, full() tells you when it is.
+	template <typename T, std::size_t CAPACITY>
+	class fixed_capacity_ring
+	{
+		using indices=detail::ring_indices<CAPACITY>;
+		
+		public:
+		using value_type		=	T;
+		using reference			=	value_type&;
+		using const_reference	=	const value_type&;
+		using pointer			=	T*;
+		using const_pointer		=	const T*;
+		using iterator			=	detail::ring_iterator<fixed_capacity_ring,T>;
+		using const_iterator	=	detail::ring_iterator<const fixed_capacity_ring,const T>;
+		using size_type			=	typename indices::index_type;
+		using difference_type	=	std::ptrdiff_t;
+		
+		fixed_capacity_ring() noexcept = default;
+		
+		fixed_capacity_ring(const fixed_capacity_ring& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
+		{
+			for(const auto& value: other)
+				push_back(value);
+		}
+		
+		fixed_capacity_ring(fixed_capacity_ring&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			for(auto& value: other)
+				push_back(std::move(value));
+		}
+		
+		~fixed_capacity_ring() noexcept
+		{
+			clear();
+		}
+		
+		//As with fixed_capacity_vector, I sacrifice exception safety here, a throwing copy leaves the ring partially filled.
+		fixed_capacity_ring& operator=(const fixed_capacity_ring& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
+		{
+			if(this!=&other)
+			{
+				clear();
+				for(const auto& value: other)
+					push_back(value);
+			}
+			return *this;
+		}
+		
+		fixed_capacity_ring& operator=(fixed_capacity_ring&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if(this!=&other)
+			{
+				clear();
+				for(auto& value: other)
+					push_back(std::move(value));
+			}
+			return *this;
+		}
+		
+		size_type size() const noexcept { return indices::distance(head_,tail_); }
+		bool empty() const noexcept { return head_==tail_; }
+		bool full() const noexcept { return size()==CAPACITY; }
+		constexpr std::size_t capacity() const noexcept { return CAPACITY; }
+		constexpr std::size_t max_size() const noexcept { return capacity(); }
+		
+		//relative to the front
+		reference operator[](std::size_t id) noexcept { return storage_[indices::slot(indices::advance(head_,id))]; }
+		const_reference operator[](std::size_t id) const noexcept { return storage_[indices::slot(indices::advance(head_,id))]; }
+		
+		#if __cpp_exceptions
+		reference at(std::size_t id) { if(!(id<size())) throw std::out_of_range{"Accessed fixed_capacity_ring out of range ;_;"}; return (*this)[id]; }
+		const_reference at(std::size_t id) const { if(!(id<size())) throw std::out_of_range{"Accessed fixed_capacity_ring out of range ;_;"}; return (*this)[id]; }
+		#endif
+		
+		reference front() noexcept { return (*this)[0]; }
+		const_reference front() const noexcept { return (*this)[0]; }
+		
+		reference back() noexcept { return (*this)[size()-1]; }
+		const_reference back() const noexcept { return (*this)[size()-1]; }
+		
+		iterator begin() noexcept { return {this,0}; }
+		const_iterator begin() const noexcept { return {this,0}; }
+		const_iterator cbegin() const noexcept { return begin(); }
+		
+		iterator end() noexcept { return {this,size()}; }
+		const_iterator end() const noexcept { return {this,size()}; }
+		const_iterator cend() const noexcept { return end(); }
+		
+		auto rbegin() noexcept { return std::make_reverse_iterator(end()); }
+		auto rbegin() const noexcept { return std::make_reverse_iterator(end()); }
+		auto crbegin() const noexcept { return std::make_reverse_iterator(end()); }
+		
+		auto rend() noexcept { return std::make_reverse_iterator(begin()); }
+		auto rend() const noexcept { return std::make_reverse_iterator(begin()); }
+		auto crend() const noexcept { return std::make_reverse_iterator(begin()); }
+		
+		void clear() noexcept(std::is_nothrow_destructible_v<T>)
+		{
+			if constexpr(!std::is_trivially_destructible_v<T>)
+			{
+				while(!empty())
+					pop_front();
+			}
+			head_=tail_=0;
+		}
+		
+		void push_back(const_reference value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+		
+		void push_front(const_reference value) { emplace_front(value); }
+		void push_front(T&& value) { emplace_front(std::move(value)); }
+		
+		template <typename... ARGS>
+		reference emplace_back(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+		{
+			auto& result=storage_.construct_at(indices::slot(tail_),std::forward<ARGS>(args)...);
+			tail_=indices::advance(tail_,1);
+			return result;
+		}
+		
+		template <typename... ARGS>
+		reference emplace_front(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+		{
+			const auto new_head=static_cast<size_type>(head_-1);
+			auto& result=storage_.construct_at(indices::slot(new_head),std::forward<ARGS>(args)...);
+			head_=new_head;
+			return result;
+		}
+		
+		void pop_front() noexcept(std::is_nothrow_destructible_v<T>)
+		{
+			storage_.destroy_at(indices::slot(head_));
+			head_=indices::advance(head_,1);
+		}
+		
+		void pop_back() noexcept(std::is_nothrow_destructible_v<T>)
+		{
+			tail_=static_cast<size_type>(tail_-1);
+			storage_.destroy_at(indices::slot(tail_));
+		}
+		
+		private:
+		detail::uninitialized_array<T,CAPACITY> storage_;
+		size_type head_=0;
+		size_type tail_=0;
+	};
+}
+
+#endif
@@ -1,34 +1,91 @@
 #ifndef PHIL_TEMPLATE_LIBRARY_FIXED_CAPACITY_VECTOR_H
 #define PHIL_TEMPLATE_LIBRARY_FIXED_CAPACITY_VECTOR_H
 
+#include <ptl/type_traits.hpp>
 #include <ptl/uint_bits.hpp>
 
 #include <algorithm>
 #include <array>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 #include <cstddef>
+#include <cstring>
 
 namespace ptl
 {
 	namespace detail
 	{
+		//memmove, through void* so gcc does not complain about relocatable but not trivially copyable types
+		template <typename T>
+		void move_bytes(T* dest, const T* source, std::size_t count) noexcept
+		{
+			std::memmove(static_cast<void*>(dest),static_cast<const void*>(source),count*sizeof(T));
+		}
+		
+		//Room for CAPACITY objects of type T, left uninitialized and constructed and destroyed by its owner as needed
+		template <typename T, std::size_t CAPACITY>
+		struct uninitialized_array
+		{
+			template <typename... ARGS>
+			T& construct_at(std::size_t pos, ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+			{
+				return *::new(static_cast<void*>(&data()[pos])) T(std::forward<ARGS>(args)...);
+			}
+			
+			void destroy_at(std::size_t pos) noexcept(std::is_nothrow_destructible_v<T>)
+			{
+				data()[pos].~T();
+			}
+			
+			T* data() noexcept { return static_cast<T*>(static_cast<void*>(storage)); }
+			const T* data() const noexcept { return static_cast<const T*>(static_cast<const void*>(storage)); }
+			
+			T& operator[](std::size_t pos) noexcept { return data()[pos]; }
+			const T& operator[](std::size_t pos) const noexcept { return data()[pos]; }
+			
+			//deliberately left uninitialized, zeroing it would cost as much as the whole capacity on every construction
+			std::aligned_storage_t<sizeof(T),alignof(T)> storage[CAPACITY];
+		};
+		
 		template <typename T, std::size_t CAPACITY>
 		struct fixed_capacity_storage_literal
 		{
-			constexpr void clear() noexcept { used=0; }
+			constexpr fixed_capacity_storage_literal() noexcept = default;
 			
-			constexpr void construct_at(ptl::uint_for_t<CAPACITY> pos, const T& val) noexcept(std::is_nothrow_copy_assignable_v<T>)
+			//user provided, so only the used elements are copied, not all of the array
+			constexpr fixed_capacity_storage_literal(const fixed_capacity_storage_literal& other) noexcept(std::is_nothrow_copy_assignable_v<T>)
 			{
-				data[pos] = val;
+				copy_from(other);
 			}
 			
-			constexpr void construct_at(ptl::uint_for_t<CAPACITY> pos, T&& val) noexcept(std::is_nothrow_move_assignable_v<T>)
+			constexpr fixed_capacity_storage_literal(fixed_capacity_storage_literal&& other) noexcept(std::is_nothrow_move_assignable_v<T>)
 			{
-				data[pos] = std::move(val);
+				move_from(other);
+			}
+			
+			constexpr fixed_capacity_storage_literal& operator=(const fixed_capacity_storage_literal& other) noexcept(std::is_nothrow_copy_assignable_v<T>)
+			{
+				copy_from(other);
+				return *this;
+			}
+			
+			constexpr fixed_capacity_storage_literal& operator=(fixed_capacity_storage_literal&& other) noexcept(std::is_nothrow_move_assignable_v<T>)
+			{
+				move_from(other);
+				return *this;
+			}
+			
+			constexpr void clear() noexcept { used=0; }
+			
+			template <typename... ARGS>
+			constexpr void construct_at(ptl::uint_for_t<CAPACITY> pos, ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...> && std::is_nothrow_move_assignable_v<T>)
+			{
+				data[pos] = T(std::forward<ARGS>(args)...);
 			}
 			
 			constexpr void destroy_at(ptl::uint_for_t<CAPACITY> pos) noexcept {}
@@ -36,6 +93,34 @@ namespace ptl
 			constexpr T* data_ptr() noexcept { return &data[0]; }
 			constexpr const T* data_ptr() const noexcept { return &data[0]; }
 			
+			constexpr void copy_from(const fixed_capacity_storage_literal& other) noexcept(std::is_nothrow_copy_assignable_v<T>)
+			{
+				used = other.used;
+				if constexpr(std::is_trivially_copyable_v<T>)
+				{
+					if(!ptl::is_constant_evaluated())
+					{
+						std::memcpy(data_ptr(),other.data_ptr(),used*sizeof(T));
+						return;
+					}
+				}
+				
+				for(std::size_t i=0;i<used;++i)
+					data[i] = other.data[i];
+			}
+			
+			constexpr void move_from(fixed_capacity_storage_literal& other) noexcept(std::is_nothrow_move_assignable_v<T>)
+			{
+				if constexpr(std::is_trivially_copyable_v<T>)
+					copy_from(other);
+				else
+				{
+					used = other.used;
+					for(std::size_t i=0;i<used;++i)
+						data[i] = std::move(other.data[i]);
+				}
+			}
+			
 			std::array<T,CAPACITY> data{};
 			ptl::uint_for_t<CAPACITY> used=0;
 		};
@@ -50,16 +135,14 @@ namespace ptl
 				std::destroy_n(data_ptr(),used);
 			}
 			
-			fixed_capacity_storage(const fixed_capacity_storage& other) noexcept(std::is_nothrow_copy_constructible_v<T>):
-				used{other.used}
+			fixed_capacity_storage(const fixed_capacity_storage& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
 			{
-				std::uninitialized_copy_n(other.data_ptr(),used,data_ptr());
+				copy_from(other);
 			}
 			
-			fixed_capacity_storage(fixed_capacity_storage&& other) noexcept(std::is_nothrow_move_constructible_v<T>):
-				used{other.used}
+			fixed_capacity_storage(fixed_capacity_storage&& other) noexcept(std::is_nothrow_move_constructible_v<T> || ptl::is_trivially_relocatable_v<T>)
 			{
-				std::uninitialized_move_n(other.data_ptr(),used,data_ptr());
+				move_from(other);
 			}
 			
 			//making the following two exception safe is a bit of a pain and also somewhat expensive at runtime.
@@ -67,17 +150,15 @@ namespace ptl
 			fixed_capacity_storage& operator=(const fixed_capacity_storage& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
 			{
 				clear();
-				used = other.used;
-				std::uninitialized_copy_n(other.data_ptr(),used,data_ptr());
+				copy_from(other);
 				
 				return *this;
 			}
 			
-			fixed_capacity_storage& operator=(fixed_capacity_storage&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+			fixed_capacity_storage& operator=(fixed_capacity_storage&& other) noexcept(std::is_nothrow_move_constructible_v<T> || ptl::is_trivially_relocatable_v<T>)
 			{
 				clear();
-				used = other.used;
-				std::uninitialized_move_n(other.data_ptr(),used,data_ptr());
+				move_from(other);
 				
 				return *this;
 			}
@@ -88,30 +169,106 @@ namespace ptl
 				used=0;
 			}
 			
-			void construct_at(ptl::uint_for_t<CAPACITY> pos, const T& val) noexcept(std::is_nothrow_copy_constructible_v<T>)
+			template <typename... ARGS>
+			void construct_at(ptl::uint_for_t<CAPACITY> pos, ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
 			{
-				::new(&data_ptr()[pos]) T{val};
+				data.construct_at(pos,std::forward<ARGS>(args)...);
 			}
 			
-			void construct_at(ptl::uint_for_t<CAPACITY> pos, T&& val) noexcept(std::is_nothrow_copy_constructible_v<T>)
+			void destroy_at(ptl::uint_for_t<CAPACITY> pos) noexcept(std::is_nothrow_destructible_v<T>)
 			{
-				::new(&data_ptr()[pos]) T{::std::move(val)};
+				data.destroy_at(pos);
 			}
 			
-			void destroy_at(ptl::uint_for_t<CAPACITY> pos) noexcept(std::is_nothrow_destructible_v<T>)
+			T* data_ptr() noexcept { return data.data(); }
+			const T* data_ptr() const noexcept { return data.data(); }
+			
+			//expects to be empty
+			void copy_from(const fixed_capacity_storage& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
 			{
-				data_ptr()[pos].~T();
+				if constexpr(std::is_trivially_copyable_v<T>)
+					std::memcpy(data_ptr(),other.data_ptr(),other.used*sizeof(T));
+				else
+					std::uninitialized_copy_n(other.data_ptr(),other.used,data_ptr());
+				used = other.used;
 			}
 			
-			T* data_ptr() noexcept { return static_cast<T*>(static_cast<void*>(data)); }
-			const T* data_ptr() const noexcept { return static_cast<const T*>(static_cast<const void*>(data)); }
-			
-			std::aligned_storage_t<sizeof(T),alignof(T)> data[CAPACITY]={};
+			//expects to be empty. Relocated elements are gone from other, moved ones are left behind in their moved from state
+			void move_from(fixed_capacity_storage& other) noexcept(std::is_nothrow_move_constructible_v<T> || ptl::is_trivially_relocatable_v<T>)
+			{
+				if constexpr(std::is_trivially_copyable_v<T>)
+					copy_from(other);
+				else if constexpr(ptl::is_trivially_relocatable_v<T>)
+				{
+					move_bytes(data_ptr(),other.data_ptr(),other.used);
+					used = other.used;
+					other.used = 0;
+				}
+				else
+				{
+					std::uninitialized_move_n(other.data_ptr(),other.used,data_ptr());
+					used = other.used;
+				}
+			}
 			
+			uninitialized_array<T,CAPACITY> data;
 			ptl::uint_for_t<CAPACITY> used=0;
 		};
+		
+		//The following work on either storage and leave its size to the caller.
+		//Each shifted element is moved to its new place and destroyed in the old one, or just memmoved if it is trivially relocatable.
+		//They are noexcept, as a move throwing halfway through would leave holes in the middle we cannot recover from. Better to terminate.
+		
+		//Moves the elements from pos on count places to the right, leaving [pos,pos+count) unconstructed.
+		template <typename T, typename STORAGE_T>
+		constexpr void open_gap(STORAGE_T& storage, std::size_t pos, std::size_t count) noexcept
+		{
+			auto* data=storage.data_ptr();
+			if constexpr(ptl::is_trivially_relocatable_v<T>)
+			{
+				if(!ptl::is_constant_evaluated())
+				{
+					move_bytes(data+pos+count,data+pos,storage.used-pos);
+					return;
+				}
+			}
+			
+			for(std::size_t i=storage.used;i>pos;--i)
+			{
+				storage.construct_at(i-1+count,std::move(data[i-1]));
+				storage.destroy_at(i-1);
+			}
+		}
+		
+		//Moves the elements from pos+count on count places to the left, into the already destroyed [pos,pos+count).
+		template <typename T, typename STORAGE_T>
+		constexpr void close_gap(STORAGE_T& storage, std::size_t pos, std::size_t count) noexcept
+		{
+			auto* data=storage.data_ptr();
+			if constexpr(ptl::is_trivially_relocatable_v<T>)
+			{
+				if(!ptl::is_constant_evaluated())
+				{
+					move_bytes(data+pos,data+pos+count,storage.used-pos-count);
+					return;
+				}
+			}
+			
+			for(std::size_t i=pos+count;i<storage.used;++i)
+			{
+				storage.construct_at(i-count,std::move(data[i]));
+				storage.destroy_at(i);
+			}
+		}
+		
+		template <typename ITER_T>
+		constexpr bool is_forward_iterator=std::is_convertible_v<typename std::iterator_traits<ITER_T>::iterator_category,std::forward_iterator_tag>;
+		
+		template <typename ITER_T>
+		using enable_if_input_iterator_t=std::enable_if_t<std::is_convertible_v<typename std::iterator_traits<ITER_T>::iterator_category,std::input_iterator_tag>>;
 	}
 	
+	//Like push_back always did, none of the functions adding elements check the capacity. Exceeding it is up to you to avoid.
 	template <typename T, std::size_t CAPACITY>
 	class fixed_capacity_vector
 	{
@@ -134,7 +291,20 @@ namespace ptl
 		using const_reference	=	const value_type&;
 		using pointer			=	T*;
 		using const_pointer		=	const T*;
+		using iterator			=	pointer;
+		using const_iterator	=	const_pointer;
 		using size_type			=	ptl::uint_for_t<CAPACITY>;
+		using difference_type	=	std::ptrdiff_t;
+		
+		constexpr fixed_capacity_vector() noexcept = default;
+		
+		constexpr explicit fixed_capacity_vector(size_type count) { resize(count); }
+		constexpr fixed_capacity_vector(size_type count, const_reference value) { assign(count,value); }
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		constexpr fixed_capacity_vector(ITER_T first, ITER_T last) { assign(first,last); }
+		
+		constexpr fixed_capacity_vector(std::initializer_list<T> values) { assign(values); }
 		
 		constexpr auto size() const noexcept { return storage_.used; }
 		constexpr auto empty() const noexcept { return size()==0; }
@@ -143,8 +313,8 @@ namespace ptl
 		
 		constexpr reference operator[](size_type id) noexcept { return data()[id]; }
 		constexpr const_reference operator[](size_type id) const noexcept { return data()[id]; }
-
-		#if __cpp_exceptions		
+		
+		#if __cpp_exceptions
 		constexpr reference at(size_type id) { if(!(id<size())) throw std::out_of_range{"Accessed fixed_capacity_vector out of range ;_;"}; return data()[id]; }
 		constexpr const_reference at(size_type id) const { if(!(id<size())) throw std::out_of_range{"Accessed fixed_capacity_vector out of range ;_;"}; return data()[id]; }
 		#endif
@@ -166,9 +336,9 @@ namespace ptl
 		constexpr auto rbegin() const noexcept { return std::make_reverse_iterator(end()); }
 		constexpr auto crbegin() const noexcept { return std::make_reverse_iterator(end()); }
 		
-		constexpr auto end() noexcept { return (&data()[size()-1])+1; }
-		constexpr auto end() const noexcept { return (&data()[size()-1])+1; }
-		constexpr auto cend() const noexcept { return (&data()[size()-1])+1; }
+		constexpr auto end() noexcept { return data()+size(); }
+		constexpr auto end() const noexcept { return data()+size(); }
+		constexpr auto cend() const noexcept { return data()+size(); }
 		
 		constexpr auto rend() noexcept { return std::make_reverse_iterator(begin()); }
 		constexpr auto rend() const noexcept { return std::make_reverse_iterator(begin()); }
@@ -179,7 +349,163 @@ namespace ptl
 		constexpr void push_back(const_reference value) noexcept(noexcept(storage_.construct_at(size(),value))) { storage_.construct_at(size(),value); ++storage_.used;  }
 		constexpr void push_back(T&& value) noexcept(noexcept(storage_.construct_at(size(),std::move(value)))) { storage_.construct_at(size(),std::move(value)); ++storage_.used; }
 		
+		template <typename... ARGS>
+		constexpr reference emplace_back(ARGS&&... args) noexcept(noexcept(storage_.construct_at(size(),std::forward<ARGS>(args)...)))
+		{
+			storage_.construct_at(size(),std::forward<ARGS>(args)...);
+			++storage_.used;
+			return back();
+		}
+		
 		constexpr void pop_back() noexcept(std::is_nothrow_destructible<T>::value) { --storage_.used; storage_.destroy_at(size()); }
+		
+		template <typename... ARGS>
+		constexpr iterator emplace(const_iterator position, ARGS&&... args)
+		{
+			const auto pos=index_of(position);
+			if(pos==size())
+			{
+				emplace_back(std::forward<ARGS>(args)...);
+				return begin()+pos;
+			}
+			
+			//constructed up front, as the arguments might refer to elements about to be moved
+			T value(std::forward<ARGS>(args)...);
+			detail::open_gap<T>(storage_,pos,1);
+			storage_.construct_at(pos,std::move(value));
+			++storage_.used;
+			return begin()+pos;
+		}
+		
+		constexpr iterator insert(const_iterator position, const_reference value) { return emplace(position,value); }
+		constexpr iterator insert(const_iterator position, T&& value) { return emplace(position,std::move(value)); }
+		
+		constexpr iterator insert(const_iterator position, size_type count, const_reference value)
+		{
+			const auto pos=index_of(position);
+			if(count==0)
+				return begin()+pos;
+			
+			const T copy(value);
+			detail::open_gap<T>(storage_,pos,count);
+			for(std::size_t i=0;i<count;++i)
+				storage_.construct_at(pos+i,copy);
+			storage_.used+=count;
+			return begin()+pos;
+		}
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		constexpr iterator insert(const_iterator position, ITER_T first, ITER_T last)
+		{
+			const auto pos=index_of(position);
+			if constexpr(detail::is_forward_iterator<ITER_T>)
+			{
+				const auto count=static_cast<std::size_t>(std::distance(first,last));
+				if(count==0)
+					return begin()+pos;
+				
+				detail::open_gap<T>(storage_,pos,count);
+				for(std::size_t i=0;i<count;++i,++first)
+					storage_.construct_at(pos+i,*first);
+				storage_.used+=count;
+			}
+			else
+			{
+				//single pass, so we cannot know how much room to make
+				for(auto it=begin()+pos;first!=last;++first,++it)
+					it=emplace(it,*first);
+			}
+			return begin()+pos;
+		}
+		
+		constexpr iterator insert(const_iterator position, std::initializer_list<T> values) { return insert(position,values.begin(),values.end()); }
+		
+		constexpr iterator erase(const_iterator position) { return erase(position,position+1); }
+		
+		constexpr iterator erase(const_iterator first, const_iterator last)
+		{
+			const auto pos=index_of(first);
+			const std::size_t count=index_of(last)-pos;
+			if(count==0)
+				return begin()+pos;
+			
+			for(std::size_t i=0;i<count;++i)
+				storage_.destroy_at(pos+i);
+			detail::close_gap<T>(storage_,pos,count);
+			storage_.used-=count;
+			return begin()+pos;
+		}
+		
+		constexpr void resize(size_type count)
+		{
+			shrink_to(count);
+			while(size()<count)
+				emplace_back();
+		}
+		
+		constexpr void resize(size_type count, const_reference value)
+		{
+			shrink_to(count);
+			while(size()<count)
+				push_back(value);
+		}
+		
+		constexpr void assign(size_type count, const_reference value)
+		{
+			clear();
+			resize(count,value);
+		}
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		constexpr void assign(ITER_T first, ITER_T last)
+		{
+			clear();
+			for(;first!=last;++first)
+				emplace_back(*first);
+		}
+		
+		constexpr void assign(std::initializer_list<T> values) { assign(values.begin(),values.end()); }
+		
+		constexpr void swap(fixed_capacity_vector& other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)
+		{
+			auto& shorter=size()<other.size()?*this:other;
+			auto& longer=size()<other.size()?other:*this;
+			
+			const std::size_t common=shorter.size();
+			for(std::size_t i=0;i<common;++i)
+			{
+				T temporary(std::move(shorter[i]));
+				shorter[i]=std::move(longer[i]);
+				longer[i]=std::move(temporary);
+			}
+			
+			const std::size_t rest=longer.size()-common;
+			if constexpr(ptl::is_trivially_relocatable_v<T>)
+			{
+				if(!ptl::is_constant_evaluated())
+				{
+					detail::move_bytes(shorter.data()+common,longer.data()+common,rest);
+					shorter.storage_.used+=rest;
+					longer.storage_.used=common;
+					return;
+				}
+			}
+			
+			for(std::size_t i=common;i<common+rest;++i)
+				shorter.push_back(std::move(longer[i]));
+			longer.shrink_to(common);
+		}
+		
+		friend constexpr void swap(fixed_capacity_vector& lhs, fixed_capacity_vector& rhs) noexcept(noexcept(lhs.swap(rhs))) { lhs.swap(rhs); }
+		
+		private:
+		constexpr size_type index_of(const_iterator position) const noexcept { return static_cast<size_type>(position-cbegin()); }
+		
+		constexpr void shrink_to(size_type count)
+		{
+			while(size()>count)
+				pop_back();
+		}
 	};
 }
 
@@ -0,0 +1,64 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_FLAT_SET_H
+#define PHIL_TEMPLATE_LIBRARY_FLAT_SET_H
+
+#include <ptl/flat_tree.hpp>
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ptl
+{
+	//Modifying the elements through iterators is possible, as with flatmap's keys, but will break things unless the order stays the same.
+	template <typename KEY_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<KEY_T>>
+	class flat_set: public detail::flat_tree<KEY_T,KEY_T,detail::key_of_identity,COMPARE_T,CONTAINER_T,true>
+	{
+		using base_t=detail::flat_tree<KEY_T,KEY_T,detail::key_of_identity,COMPARE_T,CONTAINER_T,true>;
+		
+		public:
+		using base_t::base_t;
+	};
+	
+	template <typename KEY_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<KEY_T>>
+	class flat_multiset: public detail::flat_tree<KEY_T,KEY_T,detail::key_of_identity,COMPARE_T,CONTAINER_T,false>
+	{
+		using base_t=detail::flat_tree<KEY_T,KEY_T,detail::key_of_identity,COMPARE_T,CONTAINER_T,false>;
+		
+		public:
+		using base_t::base_t;
+	};
+	
+	template <typename KEY_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	using fixed_flat_set=flat_set<KEY_T,COMPARE_T,CONTAINER_T>;
+	
+	template <typename KEY_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	using fixed_flat_multiset=flat_multiset<KEY_T,COMPARE_T,CONTAINER_T>;
+	
+	template <typename KEY_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	constexpr auto make_fixed_flat_set(COMPARE_T compare, const KEY_T (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_set<KEY_T,COMPARE_T,CONTAINER_T>>(compare,elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, std::size_t NUM, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	constexpr auto make_fixed_flat_set(const KEY_T (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_set<KEY_T,std::less<KEY_T>,CONTAINER_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	constexpr auto make_fixed_flat_multiset(COMPARE_T compare, const KEY_T (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_multiset<KEY_T,COMPARE_T,CONTAINER_T>>(compare,elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, std::size_t NUM, typename CONTAINER_T=std::array<KEY_T,NUM>>
+	constexpr auto make_fixed_flat_multiset(const KEY_T (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_multiset<KEY_T,std::less<KEY_T>,CONTAINER_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+	}
+
+} //end namespace ptl
+
+#endif
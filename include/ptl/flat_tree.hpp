@@ -0,0 +1,504 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_FLAT_TREE_H
+#define PHIL_TEMPLATE_LIBRARY_FLAT_TREE_H
+
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/ebo.hpp>
+#include <ptl/prefetch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/***
+  The sorted storage engine shared by flatmap, flat_multimap, flat_set and flat_multiset.
+  Elements are kept sorted by key in a contiguous container, KEY_OF_T extracts the key from an element and UNIQUE decides whether equivalent keys are allowed.
+  Everything not specific to maps (i.e. operator[], try_emplace and insert_or_assign) lives in here.
+***/
+
+namespace ptl
+{
+	struct sorted_unique_t { explicit sorted_unique_t() = default; };
+	inline constexpr sorted_unique_t sorted_unique{};
+	
+	struct sorted_equivalent_t { explicit sorted_equivalent_t() = default; };
+	inline constexpr sorted_equivalent_t sorted_equivalent{};
+	
+	namespace detail
+	{
+		struct key_of_first
+		{
+			template <typename T>
+			constexpr const auto& operator()(const T& value) const noexcept { return value.first; }
+		};
+		
+		struct key_of_identity
+		{
+			template <typename T>
+			constexpr const T& operator()(const T& value) const noexcept { return value; }
+		};
+		
+		template <typename KEY_T, typename VALUE_T, typename KEY_OF_T, typename COMPARE_T, typename CONTAINER_T, bool UNIQUE>
+		class flat_tree
+		{
+			public:
+			using key_type					=	KEY_T;
+			using value_type				=	VALUE_T;
+			using size_type					=	typename CONTAINER_T::size_type;
+			using difference_type			=	typename CONTAINER_T::difference_type;
+			using key_compare				=	COMPARE_T;
+			
+			using reference					=	value_type&;
+			using const_reference			=	const value_type&;
+			
+			using pointer					=	typename CONTAINER_T::pointer;
+			using const_pointer				=	typename CONTAINER_T::const_pointer;
+			
+			using iterator					=	typename CONTAINER_T::iterator;
+			using const_iterator			=	typename CONTAINER_T::const_iterator;
+			using reverse_iterator			=	typename CONTAINER_T::reverse_iterator;
+			using const_reverse_iterator	=	typename CONTAINER_T::const_reverse_iterator;
+			
+			//insert into a unique container tells us whether it did anything, in the multi ones it always succeeds
+			using insert_return_type		=	std::conditional_t<UNIQUE,std::pair<iterator, bool>,iterator>;
+			using sorted_t					=	std::conditional_t<UNIQUE,sorted_unique_t,sorted_equivalent_t>;
+			
+			struct value_compare_t: ptl::ebo_base<COMPARE_T>
+			{
+				template <typename... T>
+				constexpr value_compare_t(T&& ...args):
+					ptl::ebo_base<COMPARE_T>(std::forward<T>(args)...)
+				{}
+				
+				constexpr auto get() const noexcept { return this->get_ebo_base(ptl::typelist<COMPARE_T>{}); }
+				
+				constexpr bool operator()(const value_type& lhs, const value_type &rhs) const
+				{
+					return get().operator()(KEY_OF_T{}(lhs),KEY_OF_T{}(rhs));
+				}
+				
+				template <typename T>
+				constexpr bool operator()(const value_type &lhs, const T& rhs) const
+				{
+					return get().operator()(KEY_OF_T{}(lhs),rhs);
+				}
+				
+				template <typename T>
+				constexpr bool operator()(const T &lhs, const value_type& rhs) const
+				{
+					return get().operator()(lhs,KEY_OF_T{}(rhs));
+				}
+				
+				template <typename T>
+				constexpr bool equal(const value_type &lhs, const T& rhs) const
+				{
+					return !get().operator()(KEY_OF_T{}(lhs),rhs) && !get().operator()(rhs,KEY_OF_T{}(lhs));
+				}
+				
+				constexpr bool equal(const value_type &lhs, const value_type &rhs) const
+				{
+					return !operator()(lhs,rhs) && !operator()(rhs,lhs);
+				}
+			};
+			
+			constexpr flat_tree():
+				flat_tree(COMPARE_T{})
+			{}
+			
+			template <typename ...ARG_T>
+			explicit constexpr flat_tree(const COMPARE_T &comp, ARG_T&& ...container_args):
+				data_{comp,std::forward<ARG_T>(container_args)...}
+			{}
+			
+			//the caller promises the container contents to already be sorted (and free of duplicates for the unique variants), so we just take them as they are
+			template <typename ...ARG_T>
+			constexpr flat_tree(sorted_t, const COMPARE_T &comp, ARG_T&& ...container_args):
+				data_{comp,std::forward<ARG_T>(container_args)...}
+			{}
+			
+			template <typename ITER_T, typename = typename std::iterator_traits<ITER_T>::iterator_category>
+			constexpr flat_tree(ITER_T first, ITER_T last, const COMPARE_T &comp=COMPARE_T{}):
+				flat_tree(comp)
+			{
+				insert(first,last);
+			}
+			
+			constexpr flat_tree(std::initializer_list<value_type> values, const COMPARE_T &comp=COMPARE_T{}):
+				flat_tree(values.begin(),values.end(),comp)
+			{}
+			
+			constexpr auto begin() noexcept { return data_.storage.begin(); }
+			constexpr auto begin() const noexcept { return data_.storage.begin(); }
+			constexpr auto end() noexcept { return data_.storage.end(); }
+			constexpr auto end() const noexcept { return data_.storage.end(); }
+			
+			constexpr auto rbegin() noexcept { return data_.storage.rbegin(); }
+			constexpr auto rbegin() const noexcept { return data_.storage.rbegin(); }
+			constexpr auto rend() noexcept { return data_.storage.rend(); }
+			constexpr auto rend() const noexcept { return data_.storage.rend(); }
+			
+			constexpr auto cbegin() const noexcept { return begin(); }
+			constexpr auto cend() const noexcept { return end(); }
+			constexpr auto crbegin() const noexcept { return rbegin(); }
+			constexpr auto crend() const noexcept { return rend(); }
+			
+			constexpr auto empty() const noexcept { return data_.storage.empty(); }
+			constexpr auto size() const noexcept { return data_.storage.size(); }
+			
+			constexpr auto find(const key_type& key)
+			{
+				return find_impl(*this,key);
+			}
+			
+			constexpr auto find(const key_type& key) const
+			{
+				return find_impl(*this,key);
+			}
+			
+			//The templated overloads of find and friends only take part if the comparator is transparent, just like with std::map.
+			//They allow lookups with anything comparable to the key, e.g. a std::string_view for a std::string key, without creating a temporary key_type.
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto find(const K& key)
+			{
+				return find_impl(*this,key);
+			}
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto find(const K& key) const
+			{
+				return find_impl(*this,key);
+			}
+			
+			//Looks up every key in [first,last) and writes the result of find for each of them to out, in the same order.
+			//Sorted keys are resolved in a single galloping pass over the storage, for anything else we run several binary searches
+			//side by side, with prefetches for their next steps, so their cache misses overlap instead of happening one after another.
+			template <typename KEY_ITER_T, typename OUT_ITER_T>
+			constexpr OUT_ITER_T find_many(KEY_ITER_T first, KEY_ITER_T last, OUT_ITER_T out)
+			{
+				return find_many_impl(*this,first,last,out);
+			}
+			
+			template <typename KEY_ITER_T, typename OUT_ITER_T>
+			constexpr OUT_ITER_T find_many(KEY_ITER_T first, KEY_ITER_T last, OUT_ITER_T out) const
+			{
+				return find_many_impl(*this,first,last,out);
+			}
+			
+			constexpr size_type count(const key_type& key) const { return count_impl(key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr size_type count(const K& key) const { return count_impl(key); }
+			
+			constexpr bool contains(const key_type& key) const { return find(key)!=end(); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr bool contains(const K& key) const { return find(key)!=end(); }
+			
+			constexpr auto lower_bound(const key_type& key) { return lower_bound_impl(*this,key); }
+			constexpr auto lower_bound(const key_type& key) const { return lower_bound_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto lower_bound(const K& key) { return lower_bound_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto lower_bound(const K& key) const { return lower_bound_impl(*this,key); }
+			
+			constexpr auto upper_bound(const key_type& key) { return upper_bound_impl(*this,key); }
+			constexpr auto upper_bound(const key_type& key) const { return upper_bound_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto upper_bound(const K& key) { return upper_bound_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto upper_bound(const K& key) const { return upper_bound_impl(*this,key); }
+			
+			constexpr auto equal_range(const key_type& key) { return equal_range_impl(*this,key); }
+			constexpr auto equal_range(const key_type& key) const { return equal_range_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto equal_range(const K& key) { return equal_range_impl(*this,key); }
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr auto equal_range(const K& key) const { return equal_range_impl(*this,key); }
+			
+			constexpr insert_return_type insert(const value_type &new_val)
+			{
+				return emplace_at_key(KEY_OF_T{}(new_val),new_val);
+			}
+			
+			constexpr insert_return_type insert(value_type &&new_val)
+			{
+				return emplace_at_key(KEY_OF_T{}(new_val),std::move(new_val));
+			}
+			
+			constexpr iterator insert(const_iterator hint, const value_type &new_val)
+			{
+				return emplace_hint_at_key(hint,KEY_OF_T{}(new_val),new_val);
+			}
+			
+			constexpr iterator insert(const_iterator hint, value_type &&new_val)
+			{
+				return emplace_hint_at_key(hint,KEY_OF_T{}(new_val),std::move(new_val));
+			}
+			
+			//Inserting one by one shifts the tail every time, which is quadratic for larger batches.
+			//Instead, append everything, sort only the new part and merge it into the old one in a single pass.
+			//Both the sort and the merge are stable, so just as with repeated insert, existing elements win over new ones
+			//and the first of several equal new ones wins over the others. The multi variants keep all of them, in that same order.
+			template <typename ITER_T>
+			constexpr void insert(ITER_T first, ITER_T last)
+			{
+				const auto old_size=static_cast<difference_type>(data_.storage.size());
+				data_.storage.insert(std::end(data_.storage),first,last);
+				
+				const auto old_end=std::begin(data_.storage)+old_size;
+				std::stable_sort(old_end,std::end(data_.storage),value_compare());
+				std::inplace_merge(std::begin(data_.storage),old_end,std::end(data_.storage),value_compare());
+				
+				if constexpr(UNIQUE)
+				{
+					const auto equal=[&](const value_type& lhs, const value_type& rhs) { return value_compare().equal(lhs,rhs); };
+					data_.storage.erase(std::unique(std::begin(data_.storage),std::end(data_.storage),equal),std::end(data_.storage));
+				}
+			}
+			
+			constexpr void insert(std::initializer_list<value_type> values)
+			{
+				insert(values.begin(),values.end());
+			}
+			
+			//We need the key to know where the new element goes, so this has to construct it up front.
+			//It is moved into place afterwards, or discarded if the key is already present. For maps, use try_emplace to avoid that.
+			template <typename ...ARG_T>
+			constexpr insert_return_type emplace(ARG_T&& ...args)
+			{
+				value_type new_val(std::forward<ARG_T>(args)...);
+				return emplace_at_key(KEY_OF_T{}(new_val),std::move(new_val));
+			}
+			
+			template <typename ...ARG_T>
+			constexpr iterator emplace_hint(const_iterator hint, ARG_T&& ...args)
+			{
+				value_type new_val(std::forward<ARG_T>(args)...);
+				return emplace_hint_at_key(hint,KEY_OF_T{}(new_val),std::move(new_val));
+			}
+			
+			constexpr auto erase(iterator pos) { return data_.storage.erase(pos); }
+			constexpr auto erase(const_iterator pos) { return data_.storage.erase(pos); }
+			constexpr auto erase(const_iterator first, const_iterator last) { return data_.storage.erase(first,last); }
+			
+			constexpr size_type erase(const key_type& key)
+			{
+				return erase_impl(key);
+			}
+			
+			template <typename K, typename C=COMPARE_T, typename=typename C::is_transparent>
+			constexpr size_type erase(const K& key)
+			{
+				return erase_impl(key);
+			}
+			
+			constexpr key_compare key_comp() const { return value_compare().get(); }
+			constexpr value_compare_t value_comp() const { return value_compare(); }
+			
+			protected:
+			struct member_data: ebo_base<value_compare_t>
+			{
+				public:
+				template <typename ...ARG_T>
+				constexpr member_data(const value_compare_t& comp, ARG_T&& ...args):
+					ebo_base<value_compare_t>{comp},
+					storage(std::forward<ARG_T>(args)...)
+				{}
+				
+				CONTAINER_T storage;
+			} data_;
+			
+			constexpr const auto& value_compare() const noexcept { return data_.get_ebo_base(typelist<value_compare_t>{}); }
+			
+			template <typename const_deduced_self, typename K>
+			constexpr static auto lower_bound_impl(const_deduced_self& self, const K& key)
+			{
+				return std::lower_bound(std::begin(self.data_.storage),std::end(self.data_.storage),key,self.value_compare());
+			}
+			
+			template <typename const_deduced_self, typename K>
+			constexpr static auto upper_bound_impl(const_deduced_self& self, const K& key)
+			{
+				return std::upper_bound(std::begin(self.data_.storage),std::end(self.data_.storage),key,self.value_compare());
+			}
+			
+			template <typename const_deduced_self, typename K>
+			constexpr static auto equal_range_impl(const_deduced_self& self, const K& key)
+			{
+				return std::equal_range(std::begin(self.data_.storage),std::end(self.data_.storage),key,self.value_compare());
+			}
+			
+			template <typename const_deduced_self, typename K>
+			constexpr static auto find_impl(const_deduced_self& self, const K& key)
+			{
+				auto it=lower_bound_impl(self,key);
+				if(it==self.data_.storage.end() || !self.value_compare().equal(*it,key))
+					return self.data_.storage.end();
+				return it;
+			}
+			
+			//how many binary searches find_many runs at once, enough to keep plenty of misses in flight without running out of registers
+			static constexpr std::size_t find_many_lanes=16;
+			
+			template <typename const_deduced_self, typename KEY_ITER_T, typename OUT_ITER_T>
+			constexpr static OUT_ITER_T find_many_impl(const_deduced_self& self, KEY_ITER_T first, KEY_ITER_T last, OUT_ITER_T out)
+			{
+				const auto key_compare=self.key_comp();
+				if(std::is_sorted(first,last,key_compare))
+					return find_many_sorted(self,first,last,out);
+				
+				using iterator_t=decltype(std::begin(self.data_.storage));
+				const auto storage_begin=std::begin(self.data_.storage);
+				const auto storage_size=std::end(self.data_.storage)-storage_begin;
+				
+				while(first!=last)
+				{
+					std::array<KEY_ITER_T,find_many_lanes> keys{};
+					std::array<iterator_t,find_many_lanes> bases{};
+					std::size_t lanes=0;
+					for(;lanes<find_many_lanes && first!=last;++lanes,++first)
+					{
+						keys[lanes]=first;
+						bases[lanes]=storage_begin;
+					}
+					
+					//A branch free lower_bound in lockstep: all searches run over the same storage, so they all halve the same length.
+					//So as soon as one has taken its step, we know exactly where it looks next round and can prefetch that.
+					auto length=storage_size;
+					while(length>1)
+					{
+						const auto half=length/2;
+						const auto next_half=(length-half)/2;
+						for(std::size_t lane=0;lane<lanes;++lane)
+						{
+							if(self.value_compare()(bases[lane][half],*keys[lane]))
+								bases[lane]+=half;
+							ptl::prefetch(std::addressof(bases[lane][next_half]));
+						}
+						length-=half;
+					}
+					
+					for(std::size_t lane=0;lane<lanes;++lane)
+					{
+						auto it=bases[lane];
+						if(length==1 && self.value_compare()(*it,*keys[lane]))
+							++it;
+						*out++=it!=std::end(self.data_.storage) && self.value_compare().equal(*it,*keys[lane])?it:std::end(self.data_.storage);
+					}
+				}
+				
+				return out;
+			}
+			
+			//Galloping search from wherever the previous key ended up: doubling steps until we overshoot, then a binary search within the last step.
+			//Costs O(log d) for a key d elements after the previous one, so dense batches are about a linear merge and sparse ones about independent searches.
+			template <typename const_deduced_self, typename KEY_ITER_T, typename OUT_ITER_T>
+			constexpr static OUT_ITER_T find_many_sorted(const_deduced_self& self, KEY_ITER_T first, KEY_ITER_T last, OUT_ITER_T out)
+			{
+				auto pos=std::begin(self.data_.storage);
+				const auto storage_end=std::end(self.data_.storage);
+				for(;first!=last;++first)
+				{
+					const auto& key=*first;
+					const auto remaining=storage_end-pos;
+					
+					difference_type bound=1;
+					while(bound<=remaining && self.value_compare()(pos[bound-1],key))
+						bound*=2;
+					
+					pos=std::lower_bound(pos+bound/2,pos+std::min(bound,remaining),key,self.value_compare());
+					*out++=pos!=storage_end && self.value_compare().equal(*pos,key)?pos:storage_end;
+				}
+				
+				return out;
+			}
+			
+			template <typename K>
+			constexpr size_type count_impl(const K& key) const
+			{
+				if constexpr(UNIQUE)
+					return find(key)!=end()?1:0;
+				else
+				{
+					auto range=equal_range_impl(*this,key);
+					return static_cast<size_type>(std::distance(range.first,range.second));
+				}
+			}
+			
+			template <typename K>
+			constexpr size_type erase_impl(const K& key)
+			{
+				auto range=equal_range_impl(*this,key);
+				const auto count=static_cast<size_type>(std::distance(range.first,range.second));
+				data_.storage.erase(range.first,range.second);
+				return count;
+			}
+			
+			//Key is only used for searching and has to stay valid until the new element is constructed.
+			//Equivalent elements go after the ones already present, just like with std::multimap.
+			template <typename ...ARG_T>
+			constexpr insert_return_type emplace_at_key(const key_type& key, ARG_T&& ...args)
+			{
+				if constexpr(UNIQUE)
+				{
+					auto it=lower_bound_impl(*this,key);
+					if(it!=data_.storage.end() && value_compare().equal(*it,key))
+						return std::pair<iterator, bool>(it,false);
+					return std::pair<iterator, bool>(data_.storage.emplace(it,std::forward<ARG_T>(args)...),true);
+				}
+				else
+					return data_.storage.emplace(upper_bound_impl(*this,key),std::forward<ARG_T>(args)...);
+			}
+			
+			//A correct hint is the position right after where key belongs, as for std::map, which saves us the binary search entirely.
+			//Otherwise, we fall back to the usual search.
+			template <typename ...ARG_T>
+			constexpr iterator emplace_hint_at_key(const_iterator hint, const key_type& key, ARG_T&& ...args)
+			{
+				bool fits_before_hint=true;
+				bool fits_after_previous=true;
+				if constexpr(UNIQUE)
+				{
+					fits_before_hint=hint==data_.storage.cend() || value_compare()(key,*hint);
+					fits_after_previous=hint==data_.storage.cbegin() || value_compare()(*std::prev(hint),key);
+				}
+				else
+				{
+					fits_before_hint=hint==data_.storage.cend() || !value_compare()(*hint,key);
+					fits_after_previous=hint==data_.storage.cbegin() || !value_compare()(key,*std::prev(hint));
+				}
+				
+				if(fits_before_hint && fits_after_previous)
+					return data_.storage.emplace(hint,std::forward<ARG_T>(args)...);
+				
+				if constexpr(UNIQUE)
+					return emplace_at_key(key,std::forward<ARG_T>(args)...).first;
+				else
+					return emplace_at_key(key,std::forward<ARG_T>(args)...);
+			}
+		};
+		
+		//shared by all the make_fixed_* functions: copies the elements into an array, sorts them by key and hands them to the requested container
+		template <typename RESULT_T, typename COMPARE_T, typename VALUE_T, std::size_t NUM, std::size_t ...IDX>
+		constexpr auto make_fixed_flat_tree(COMPARE_T compare, const VALUE_T (&elements)[NUM], std::index_sequence<IDX...>)
+		{
+			std::array<VALUE_T,NUM> arr{{elements[IDX]...}};
+			
+			ptl::constexpr_algorithm::sort(std::begin(arr),std::end(arr),typename RESULT_T::value_compare_t{compare});
+			return RESULT_T{compare,arr};
+		}
+	}
+
+} //end namespace ptl
+
+#endif
@@ -1,204 +1,173 @@
 #ifndef PHIL_TEMPLATE_LIBRARY_FLATMAP_H
 #define PHIL_TEMPLATE_LIBRARY_FLATMAP_H
 
-#include <ptl/constexpr_algorithm.hpp>
-#include <ptl/ebo.hpp>
+#include <ptl/flat_tree.hpp>
 
-#include <algorithm>
+#include <array>
 #include <functional>
 #include <stdexcept>
-#include <type_traits>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace ptl
 {
-	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<std::pair<KEY_T,MAPPED_T>>>
-	class flatmap
+	namespace detail
 	{
-		public:
-		using key_type					=	KEY_T;
-		using mapped_type				=	MAPPED_T;
-		using value_type				=	std::pair<KEY_T,MAPPED_T>;
-		using size_type					=	typename CONTAINER_T::size_type;
-		using difference_type			=	typename CONTAINER_T::difference_type;
-		using key_compare				=	COMPARE_T;
-		
-		using reference					=	value_type&;
-		using const_reference			=	const value_type&;
-		
-		using pointer					=	typename CONTAINER_T::pointer;
-		using const_pointer				=	typename CONTAINER_T::const_pointer;
-		
-		using iterator					=	typename CONTAINER_T::iterator;
-		using const_iterator			=	typename CONTAINER_T::const_iterator;
-		using reverse_iterator			=	typename CONTAINER_T::reverse_iterator;
-		using const_reverse_iterator	=	typename CONTAINER_T::const_reverse_iterator;
-		
-		struct value_compare_t: ptl::ebo_base<COMPARE_T>
+		//the parts shared by flatmap and flat_multimap, but not by the sets
+		template <typename KEY_T, typename MAPPED_T, typename COMPARE_T, typename CONTAINER_T, bool UNIQUE>
+		class flat_map_base: public flat_tree<KEY_T,std::pair<KEY_T,MAPPED_T>,key_of_first,COMPARE_T,CONTAINER_T,UNIQUE>
 		{
-			template <typename... T>
-			constexpr value_compare_t(T&& ...args):
-				ptl::ebo_base<COMPARE_T>(std::forward<T>(args)...)
-			{}
+			using base_t=flat_tree<KEY_T,std::pair<KEY_T,MAPPED_T>,key_of_first,COMPARE_T,CONTAINER_T,UNIQUE>;
+			
+			public:
+			using mapped_type=MAPPED_T;
+			
+			using typename base_t::key_type;
+			using typename base_t::iterator;
+			using typename base_t::const_iterator;
+			using typename base_t::insert_return_type;
 			
-			constexpr auto get() const noexcept { return this->get_ebo_base(ptl::typelist<COMPARE_T>{}); }
+			using base_t::base_t;
 			
-			constexpr bool operator()(const value_type& lhs, const value_type &rhs) const
+			//Unlike emplace, these only construct the new element if it is actually inserted, and then directly in its final place.
+			template <typename ...ARG_T>
+			constexpr insert_return_type try_emplace(const key_type& key, ARG_T&& ...args)
 			{
-				return get().operator()(lhs.first,rhs.first);
+				return this->emplace_at_key(key,std::piecewise_construct,std::forward_as_tuple(key),std::forward_as_tuple(std::forward<ARG_T>(args)...));
 			}
 			
-			template <typename T>
-			constexpr bool operator()(const value_type &lhs, const T& rhs) const
+			template <typename ...ARG_T>
+			constexpr insert_return_type try_emplace(key_type&& key, ARG_T&& ...args)
 			{
-				return get().operator()(lhs.first,rhs);
+				return this->emplace_at_key(key,std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::forward_as_tuple(std::forward<ARG_T>(args)...));
 			}
 			
-			template <typename T>
-			constexpr bool equal(const value_type &lhs, const T& rhs) const
+			template <typename ...ARG_T>
+			constexpr iterator try_emplace(const_iterator hint, const key_type& key, ARG_T&& ...args)
 			{
-				return !get().operator()(lhs.first,rhs) && !get().operator()(rhs,lhs.first);
+				return this->emplace_hint_at_key(hint,key,std::piecewise_construct,std::forward_as_tuple(key),std::forward_as_tuple(std::forward<ARG_T>(args)...));
 			}
 			
-			constexpr bool equal(const value_type &lhs, const value_type &rhs) const
+			template <typename ...ARG_T>
+			constexpr iterator try_emplace(const_iterator hint, key_type&& key, ARG_T&& ...args)
 			{
-				return !operator()(lhs,rhs) && !operator()(rhs,lhs);
+				return this->emplace_hint_at_key(hint,key,std::piecewise_construct,std::forward_as_tuple(std::move(key)),std::forward_as_tuple(std::forward<ARG_T>(args)...));
 			}
 		};
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<std::pair<KEY_T,MAPPED_T>>>
+	class flatmap: public detail::flat_map_base<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T,true>
+	{
+		using base_t=detail::flat_map_base<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T,true>;
 		
-		constexpr flatmap():
-			flatmap(COMPARE_T{})
-		{}
-		
-		template <typename ...ARG_T>
-		explicit constexpr flatmap(const COMPARE_T &comp, ARG_T&& ...container_args):
-			data_{comp,std::forward<ARG_T>(container_args)...}
-		{}
-		
-		constexpr auto begin() noexcept { return data_.storage.begin(); }
-		constexpr auto begin() const noexcept { return data_.storage.begin(); }
-		constexpr auto end() noexcept { return data_.storage.end(); }
-		constexpr auto end() const noexcept { return data_.storage.end(); }
-		
-		constexpr auto rbegin() noexcept { return data_.storage.rbegin(); }
-		constexpr auto rbegin() const noexcept { return data_.storage.rbegin(); }
-		constexpr auto rend() noexcept { return data_.storage.rend(); }
-		constexpr auto rend() const noexcept { return data_.storage.rend(); }
-		
-		constexpr auto cbegin() const noexcept { return begin(); }
-		constexpr auto cend() const noexcept { return end(); }
-		constexpr auto crbegin() const noexcept { return rbegin(); }
-		constexpr auto crend() const noexcept { return rend(); }
+		public:
+		using typename base_t::key_type;
+		using typename base_t::iterator;
+		using typename base_t::const_iterator;
 		
-		constexpr auto empty() const noexcept { return data_.storage.empty(); }
-		constexpr auto size() const noexcept { return data_.storage.size(); }
+		using base_t::base_t;
 		
-		constexpr auto find(const key_type& key)
+		template <typename M>
+		constexpr std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
 		{
-			return find_impl(*this,key);
+			auto ret_val=this->try_emplace(key,std::forward<M>(obj));
+			if(!ret_val.second)
+				ret_val.first->second=std::forward<M>(obj);
+			return ret_val;
 		}
 		
-		constexpr auto find(const key_type& key) const
+		template <typename M>
+		constexpr std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
 		{
-			return find_impl(*this,key);
+			auto ret_val=this->try_emplace(std::move(key),std::forward<M>(obj));
+			if(!ret_val.second)
+				ret_val.first->second=std::forward<M>(obj);
+			return ret_val;
 		}
 		
-		constexpr std::pair<iterator, bool> insert(const value_type &new_val)
+		template <typename M>
+		constexpr iterator insert_or_assign(const_iterator hint, const key_type& key, M&& obj)
 		{
-			auto it=std::lower_bound(std::begin(data_.storage),std::end(data_.storage),new_val,value_compare());
-			if(it!=data_.storage.end() && value_compare().equal(*it,new_val))
-				return std::pair<iterator, bool>(it,false);
-			return std::pair<iterator, bool>(data_.storage.insert(it,new_val),true);
+			const auto old_size=this->size();
+			auto it=this->try_emplace(hint,key,std::forward<M>(obj));
+			if(this->size()==old_size)
+				it->second=std::forward<M>(obj);
+			return it;
 		}
 		
-		constexpr auto erase(iterator pos) { return data_.storage.erase(pos); }
-		constexpr auto erase(const_iterator pos) { return data_.storage.erase(pos); }
-		
-		
-		constexpr size_type erase(const key_type& key)
+		template <typename M>
+		constexpr iterator insert_or_assign(const_iterator hint, key_type&& key, M&& obj)
 		{
-			if(auto it=find(key); it!=data_.storage.end())
-			{
-				erase(it);
-				return 1;
-			}
-			return 0;
+			const auto old_size=this->size();
+			auto it=this->try_emplace(hint,std::move(key),std::forward<M>(obj));
+			if(this->size()==old_size)
+				it->second=std::forward<M>(obj);
+			return it;
 		}
 		
 		constexpr auto& operator[](const key_type &key)
 		{
-			auto it=std::lower_bound(std::begin(data_.storage),std::end(data_.storage),key,value_compare());
-			if(it!=data_.storage.end() && value_compare().equal(*it,key))
-				return it->second;
-			return data_.storage.insert(it,value_type(key,{}))->second;
+			return this->try_emplace(key).first->second;
+		}
+		
+		constexpr auto& operator[](key_type &&key)
+		{
+			return this->try_emplace(std::move(key)).first->second;
 		}
 		
 		constexpr const auto& operator[](const key_type &key) const
 		{
-			auto it=std::lower_bound(std::begin(data_.storage),std::end(data_.storage),key,value_compare());
-			if(it!=data_.storage.end() && value_compare().equal(*it,key))
+			if(auto it=this->find(key); it!=this->end())
 				return it->second;
 			
 			throw std::out_of_range{"Tried to access nonexistent element with operator[] on a const object..."};
 		}
+	};
+	
+	//Just like std::multimap, elements with equivalent keys stay in the order they were inserted in and there is no operator[] or insert_or_assign.
+	//try_emplace is still around, it always inserts, but saves constructing a temporary pair.
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::vector<std::pair<KEY_T,MAPPED_T>>>
+	class flat_multimap: public detail::flat_map_base<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T,false>
+	{
+		using base_t=detail::flat_map_base<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T,false>;
 		
-		private:
-		struct member_data: ebo_base<value_compare_t>
-		{
-			public:
-			template <typename ...ARG_T>
-			constexpr member_data(const value_compare_t& comp, ARG_T&& ...args):
-				ebo_base<value_compare_t>{comp},
-				storage(std::forward<ARG_T>(args)...)
-			{}
-			
-			CONTAINER_T storage;
-		} data_;
-		
-		constexpr const auto& value_compare() const noexcept { return data_.get_ebo_base(typelist<value_compare_t>{}); }
-		
-		template <typename const_deduced_self>
-		constexpr static auto find_impl(const_deduced_self& self, const key_type& key)
-		{
-			auto it=std::lower_bound(std::begin(self.data_.storage),std::end(self.data_.storage),key,self.value_compare());
-			if(it==self.data_.storage.end() || !self.value_compare().equal(*it,key))
-				return self.data_.storage.end();
-			return it;
-		}
+		public:
+		using base_t::base_t;
 	};
 	
 	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
 	using fixed_flatmap=flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>;
 	
-	namespace detail
-	{	
-		template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>, std::size_t ...IDX>
-		constexpr auto make_fixed_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM],std::index_sequence<IDX...>)
-		{
-			std::array<std::pair<KEY_T,MAPPED_T>,NUM> arr{{elements[IDX]...}};
-			
-			const auto compare_first = [&](const auto& lhs, const auto& rhs)
-			{
-				return compare(lhs.first,rhs.first);
-			};
-			
-			ptl::constexpr_algorithm::sort(std::begin(arr),std::end(arr),compare_first);
-			return ptl::flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>{compare,arr};
-		}
-	}
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
+	using fixed_flat_multimap=flat_multimap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>;
 	
 	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
 	constexpr auto make_fixed_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
 	{
-		return detail::make_fixed_flatmap<KEY_T,MAPPED_T,NUM,COMPARE_T,CONTAINER_T>(compare,elements,std::make_index_sequence<NUM>{});
+		return detail::make_fixed_flat_tree<ptl::flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>>(compare,elements,std::make_index_sequence<NUM>{});
 	}
 	
 	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
 	constexpr auto make_fixed_flatmap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
 	{
-		return detail::make_fixed_flatmap<KEY_T,MAPPED_T,NUM,std::less<KEY_T>,CONTAINER_T>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+		return detail::make_fixed_flat_tree<ptl::flatmap<KEY_T,MAPPED_T,std::less<KEY_T>,CONTAINER_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
 	}
 	
+	//the constexpr sort is not stable, so unlike with insert, the order among equivalent keys is unspecified here
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
+	constexpr auto make_fixed_flat_multimap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_multimap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>>(compare,elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename CONTAINER_T=std::array<std::pair<KEY_T,MAPPED_T>,NUM>>
+	constexpr auto make_fixed_flat_multimap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_flat_tree<ptl::flat_multimap<KEY_T,MAPPED_T,std::less<KEY_T>,CONTAINER_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+	}
+
 } //end namespace ptl
 
 #endif
@@ -0,0 +1,288 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_MAPPED_FLATMAP_H
+#define PHIL_TEMPLATE_LIBRARY_MAPPED_FLATMAP_H
+
+#include <ptl/flatmap.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/***
+  A binary file format for flatmaps of trivially copyable keys and values, and a read-only view serving lookups straight from the mmapped file.
+  The file is a fixed header followed by the sorted std::pair<KEY_T,MAPPED_T> elements exactly as they are laid out in memory,
+  so opening one is a handful of checks on the header and everything else is left to the page cache, shared by all processes using the same file.
+  As a consequence, files are only portable between machines and compilers agreeing on the layout of those pairs, which the header checks as well as it can.
+  The view has to be used with the same ordering the map was written with. POSIX only.
+***/
+
+namespace ptl
+{
+	namespace detail
+	{
+		struct mapped_flatmap_header
+		{
+			static constexpr std::array<char,8> expected_magic{{'p','t','l','f','m','a','p','\0'}};
+			static constexpr std::uint32_t current_version=1;
+			static constexpr std::uint32_t expected_byte_order=0x01020304;
+			
+			std::array<char,8> magic;
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			std::uint64_t count;
+			std::uint32_t key_size;
+			std::uint32_t mapped_size;
+			std::uint32_t value_size;
+			std::uint32_t value_alignment;
+			std::uint64_t data_offset;
+			//FNV-1a over all element bytes
+			std::uint64_t checksum;
+		};
+		
+		inline std::uint64_t mapped_flatmap_checksum(const unsigned char* data, std::size_t size) noexcept
+		{
+			std::uint64_t hash=0xcbf29ce484222325ull;
+			for(std::size_t i=0;i<size;++i)
+			{
+				hash^=data[i];
+				hash*=0x100000001b3ull;
+			}
+			return hash;
+		}
+		
+		template <typename VALUE_T>
+		constexpr std::uint64_t mapped_flatmap_data_offset() noexcept
+		{
+			constexpr std::uint64_t alignment=alignof(VALUE_T);
+			return (sizeof(mapped_flatmap_header)+alignment-1)/alignment*alignment;
+		}
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T, typename CONTAINER_T>
+	void write_mapped_flatmap(const std::string& path, const ptl::flatmap<KEY_T,MAPPED_T,COMPARE_T,CONTAINER_T>& map)
+	{
+		static_assert(std::is_trivially_copyable_v<KEY_T> && std::is_trivially_copyable_v<MAPPED_T>,"Only trivially copyable keys and values can be written as raw bytes");
+		
+		using value_type=std::pair<KEY_T,MAPPED_T>;
+		constexpr auto data_offset=detail::mapped_flatmap_data_offset<value_type>();
+		
+		//built in a zeroed buffer, so padding bytes are deterministic and do not upset the checksum
+		std::vector<unsigned char> buffer(data_offset+map.size()*sizeof(value_type));
+		auto elements=buffer.data()+data_offset;
+		for(const auto& element: map)
+		{
+			::new(static_cast<void*>(elements)) value_type(element);
+			elements+=sizeof(value_type);
+		}
+		
+		detail::mapped_flatmap_header header{};
+		header.magic=detail::mapped_flatmap_header::expected_magic;
+		header.version=detail::mapped_flatmap_header::current_version;
+		header.byte_order=detail::mapped_flatmap_header::expected_byte_order;
+		header.count=map.size();
+		header.key_size=sizeof(KEY_T);
+		header.mapped_size=sizeof(MAPPED_T);
+		header.value_size=sizeof(value_type);
+		header.value_alignment=alignof(value_type);
+		header.data_offset=data_offset;
+		header.checksum=detail::mapped_flatmap_checksum(buffer.data()+data_offset,buffer.size()-data_offset);
+		std::memcpy(buffer.data(),&header,sizeof(header));
+		
+		std::ofstream file{path,std::ios::binary|std::ios::trunc};
+		if(!file.write(reinterpret_cast<const char*>(buffer.data()),static_cast<std::streamsize>(buffer.size())))
+			throw std::runtime_error{"Could not write mapped flatmap to "+path};
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>>
+	class mapped_flatmap: private ebo_bases<COMPARE_T>
+	{
+		public:
+		using key_type					=	KEY_T;
+		using mapped_type				=	MAPPED_T;
+		using value_type				=	std::pair<KEY_T,MAPPED_T>;
+		using size_type					=	std::size_t;
+		using difference_type			=	std::ptrdiff_t;
+		using key_compare				=	COMPARE_T;
+		
+		using reference					=	const value_type&;
+		using const_reference			=	const value_type&;
+		
+		using iterator					=	const value_type*;
+		using const_iterator			=	const value_type*;
+		using reverse_iterator			=	std::reverse_iterator<const_iterator>;
+		using const_reverse_iterator	=	std::reverse_iterator<const_iterator>;
+		
+		//Only the header is validated by default, which keeps opening O(1). verify_checksum reads the whole file once.
+		explicit mapped_flatmap(const std::string& path, bool verify_checksum=false, const COMPARE_T& comp=COMPARE_T{}):
+			ebo_bases<COMPARE_T>{comp}
+		{
+			static_assert(std::is_trivially_copyable_v<KEY_T> && std::is_trivially_copyable_v<MAPPED_T>,"Only trivially copyable keys and values can be mapped");
+			
+			const auto fd=::open(path.c_str(),O_RDONLY|O_CLOEXEC);
+			if(fd==-1)
+				throw std::system_error{errno,std::generic_category(),"Could not open "+path};
+			
+			struct ::stat file_info{};
+			if(::fstat(fd,&file_info)==-1)
+			{
+				const auto error=errno;
+				::close(fd);
+				throw std::system_error{error,std::generic_category(),"Could not stat "+path};
+			}
+			
+			mapping_size_=static_cast<std::size_t>(file_info.st_size);
+			if(mapping_size_<sizeof(detail::mapped_flatmap_header))
+			{
+				::close(fd);
+				throw std::runtime_error{path+" is too small to be a mapped flatmap"};
+			}
+			
+			mapping_=::mmap(nullptr,mapping_size_,PROT_READ,MAP_SHARED,fd,0);
+			const auto error=errno;
+			//the mapping stays valid without the descriptor
+			::close(fd);
+			if(mapping_==MAP_FAILED)
+				throw std::system_error{error,std::generic_category(),"Could not map "+path};
+			
+			try
+			{
+				validate(path,verify_checksum);
+			}
+			catch(...)
+			{
+				::munmap(mapping_,mapping_size_);
+				throw;
+			}
+		}
+		
+		mapped_flatmap(mapped_flatmap&& other) noexcept:
+			ebo_bases<COMPARE_T>{other.key_comp()},
+			mapping_{std::exchange(other.mapping_,nullptr)},
+			mapping_size_{std::exchange(other.mapping_size_,0)},
+			elements_{std::exchange(other.elements_,nullptr)},
+			size_{std::exchange(other.size_,0)}
+		{}
+		
+		mapped_flatmap& operator=(mapped_flatmap&& other) noexcept
+		{
+			static_cast<ebo_bases<COMPARE_T>&>(*this)=static_cast<ebo_bases<COMPARE_T>&>(other);
+			std::swap(mapping_,other.mapping_);
+			std::swap(mapping_size_,other.mapping_size_);
+			std::swap(elements_,other.elements_);
+			std::swap(size_,other.size_);
+			return *this;
+		}
+		
+		~mapped_flatmap()
+		{
+			if(mapping_)
+				::munmap(mapping_,mapping_size_);
+		}
+		
+		auto begin() const noexcept { return elements_; }
+		auto end() const noexcept { return elements_+size_; }
+		
+		auto rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		auto rend() const noexcept { return const_reverse_iterator{begin()}; }
+		
+		auto cbegin() const noexcept { return begin(); }
+		auto cend() const noexcept { return end(); }
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+		
+		auto empty() const noexcept { return size_==0; }
+		auto size() const noexcept { return size_; }
+		
+		auto lower_bound(const key_type& key) const
+		{
+			return std::lower_bound(begin(),end(),key,[this](const value_type& lhs, const key_type& rhs) { return key_comp()(lhs.first,rhs); });
+		}
+		
+		auto upper_bound(const key_type& key) const
+		{
+			return std::upper_bound(begin(),end(),key,[this](const key_type& lhs, const value_type& rhs) { return key_comp()(lhs,rhs.first); });
+		}
+		
+		auto equal_range(const key_type& key) const
+		{
+			return std::pair<const_iterator, const_iterator>(lower_bound(key),upper_bound(key));
+		}
+		
+		auto find(const key_type& key) const
+		{
+			auto it=lower_bound(key);
+			if(it==end() || key_comp()(key,it->first))
+				return end();
+			return it;
+		}
+		
+		size_type count(const key_type& key) const { return find(key)!=end()?1:0; }
+		bool contains(const key_type& key) const { return find(key)!=end(); }
+		
+		const auto& operator[](const key_type &key) const
+		{
+			if(auto it=find(key); it!=end())
+				return it->second;
+			
+			throw std::out_of_range{"Tried to access nonexistent element with operator[] on a mapped flatmap..."};
+		}
+		
+		key_compare key_comp() const { return this->get_ebo_base(typelist<COMPARE_T>{}); }
+		
+		private:
+		void* mapping_=nullptr;
+		std::size_t mapping_size_=0;
+		const value_type* elements_=nullptr;
+		size_type size_=0;
+		
+		void validate(const std::string& path, bool verify_checksum)
+		{
+			using header_t=detail::mapped_flatmap_header;
+			
+			header_t header;
+			std::memcpy(&header,mapping_,sizeof(header));
+			
+			const auto fail=[&](const char* reason) { throw std::runtime_error{path+" is not a usable mapped flatmap: "+reason}; };
+			if(header.magic!=header_t::expected_magic)
+				fail("wrong magic number");
+			if(header.version!=header_t::current_version)
+				fail("unsupported version");
+			if(header.byte_order!=header_t::expected_byte_order)
+				fail("written with a different byte order");
+			if(header.key_size!=sizeof(KEY_T) || header.mapped_size!=sizeof(MAPPED_T) || header.value_size!=sizeof(value_type) || header.value_alignment!=alignof(value_type))
+				fail("written for different key or mapped types");
+			if(header.data_offset!=detail::mapped_flatmap_data_offset<value_type>())
+				fail("unexpected data offset");
+			if(header.count>(mapping_size_-header.data_offset)/sizeof(value_type))
+				fail("truncated");
+			
+			const auto data=static_cast<const unsigned char*>(mapping_)+header.data_offset;
+			if(verify_checksum && detail::mapped_flatmap_checksum(data,header.count*sizeof(value_type))!=header.checksum)
+				fail("checksum mismatch");
+			
+			//mmap hands out page aligned memory and data_offset is a multiple of the alignment
+			elements_=std::launder(reinterpret_cast<const value_type*>(data));
+			size_=header.count;
+		}
+	};
+
+} //end namespace ptl
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_MPMC_QUEUE_H
+#define PHIL_TEMPLATE_LIBRARY_MPMC_QUEUE_H
+
+#include <ptl/fixed_capacity_vector.hpp>
+#include <ptl/new.hpp>
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+/***
+  A bounded queue for any number of producer and consumer threads, after Dmitry Vyukov's: lock-free, no allocations and the same interface as spsc_queue.
+  Every slot carries a sequence number telling whose turn it is: equal to a position, the slot is free for whoever pushes at it,
+  one past it, it holds the element for whoever pops at it. Producers and consumers each claim positions by bumping a counter of their own
+  (on its own cache line) with a compare and swap, then fill or empty the slot and hand it on by storing the next sequence number.
+  Producers and consumers only ever contend among themselves, and only on that counter. The batched versions claim as many consecutive positions as
+  are ready with a single compare and swap.
+  A claimed slot has to be filled, or no one gets past it anymore: constructing an element in it must not throw.
+***/
+
+namespace ptl
+{
+	template <typename T, std::size_t CAPACITY>
+	class mpmc_queue
+	{
+		static_assert(CAPACITY>=2 && (CAPACITY&(CAPACITY-1))==0,"mpmc_queue capacities have to be powers of two, and at least 2 ;_;");
+		static_assert(std::atomic<std::size_t>::is_always_lock_free,"mpmc_queue needs lock free atomic sequence numbers ;_;");
+		
+		public:
+		using value_type	=	T;
+		using size_type		=	std::size_t;
+		
+		mpmc_queue() noexcept
+		{
+			for(std::size_t i=0;i<CAPACITY;++i)
+				cells_[i].sequence.store(i,std::memory_order_relaxed);
+		}
+		
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+		
+		//no thread may use the queue anymore by now
+		~mpmc_queue() noexcept
+		{
+			const auto last=enqueue_pos_.load(std::memory_order_relaxed);
+			for(auto pos=dequeue_pos_.load(std::memory_order_relaxed);pos!=last;++pos)
+				cell_at(pos).value.destroy_at(0);
+		}
+		
+		template <typename... ARGS>
+		bool try_emplace(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+		{
+			const auto pos=claim(enqueue_pos_,1,0);
+			if(pos.count==0)
+				return false;
+			
+			auto& cell=cell_at(pos.first);
+			cell.value.construct_at(0,std::forward<ARGS>(args)...);
+			cell.sequence.store(pos.first+1,std::memory_order_release);
+			return true;
+		}
+		
+		bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return try_emplace(value); }
+		bool try_push(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) { return try_emplace(std::move(value)); }
+		
+		//Pushes as many elements of [first,last) as there are consecutive free slots and returns the iterator past the last one pushed.
+		//Needs to know how many to claim before copying, hence the forward iterators.
+		template <typename ITER_T>
+		ITER_T try_push(ITER_T first, ITER_T last)
+		{
+			const auto wanted=static_cast<std::size_t>(std::distance(first,last));
+			if(wanted==0)
+				return first;
+			
+			const auto pos=claim(enqueue_pos_,wanted<CAPACITY?wanted:CAPACITY,0);
+			for(std::size_t i=0;i<pos.count;++i,++first)
+			{
+				auto& cell=cell_at(pos.first+i);
+				cell.value.construct_at(0,*first);
+				cell.sequence.store(pos.first+i+1,std::memory_order_release);
+			}
+			return first;
+		}
+		
+		bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_destructible_v<T>)
+		{
+			const auto pos=claim(dequeue_pos_,1,1);
+			if(pos.count==0)
+				return false;
+			
+			take(pos.first,value);
+			return true;
+		}
+		
+		//Pops up to max_count elements into out and returns how many that were.
+		template <typename OUTPUT_ITER_T>
+		std::size_t try_pop(OUTPUT_ITER_T out, std::size_t max_count)
+		{
+			if(max_count==0)
+				return 0;
+			
+			const auto pos=claim(dequeue_pos_,max_count<CAPACITY?max_count:CAPACITY,1);
+			for(std::size_t i=0;i<pos.count;++i,++out)
+				take(pos.first+i,*out);
+			return pos.count;
+		}
+		
+		//only a snapshot when called while others are busy
+		size_type size_approx() const noexcept
+		{
+			const auto dequeued=dequeue_pos_.load(std::memory_order_acquire);
+			const auto enqueued=enqueue_pos_.load(std::memory_order_acquire);
+			return enqueued>dequeued?enqueued-dequeued:0;
+		}
+		
+		bool empty_approx() const noexcept { return size_approx()==0; }
+		constexpr size_type capacity() const noexcept { return CAPACITY; }
+		
+		private:
+		struct cell
+		{
+			std::atomic<std::size_t> sequence;
+			detail::uninitialized_array<T,1> value;
+		};
+		
+		struct claimed
+		{
+			std::size_t first;
+			std::size_t count;
+		};
+		
+		cell& cell_at(std::size_t pos) noexcept { return cells_[pos&(CAPACITY-1)]; }
+		
+		//Claims up to max_count consecutive positions from counter, as long as the slots at them are ready, i.e. have a sequence number of their position plus offset.
+		//Slots cannot stop being ready before the counter has moved past them, which makes our compare and swap fail, so checking them first is fine.
+		claimed claim(std::atomic<std::size_t>& counter, std::size_t max_count, std::size_t offset) noexcept
+		{
+			auto pos=counter.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				std::size_t count=0;
+				std::ptrdiff_t difference=0;
+				while(count<max_count)
+				{
+					const auto sequence=cell_at(pos+count).sequence.load(std::memory_order_acquire);
+					difference=static_cast<std::ptrdiff_t>(sequence-(pos+count+offset));
+					if(difference!=0)
+						break;
+					++count;
+				}
+				
+				if(count>0)
+				{
+					if(counter.compare_exchange_weak(pos,pos+count,std::memory_order_relaxed))
+						return {pos,count};
+				}
+				else if(difference<0) //full, or empty when popping
+					return {pos,0};
+				else //someone else got further already, start over from where they are
+					pos=counter.load(std::memory_order_relaxed);
+			}
+		}
+		
+		template <typename DEST_T>
+		void take(std::size_t pos, DEST_T&& dest)
+		{
+			auto& cell=cell_at(pos);
+			dest=std::move(cell.value[0]);
+			cell.value.destroy_at(0);
+			cell.sequence.store(pos+CAPACITY,std::memory_order_release);
+		}
+		
+		alignas(ptl::hardware_destructive_interference_size) std::atomic<std::size_t> enqueue_pos_{0};
+		alignas(ptl::hardware_destructive_interference_size) std::atomic<std::size_t> dequeue_pos_{0};
+		alignas(ptl::hardware_destructive_interference_size) std::array<cell,CAPACITY> cells_;
+	};
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_NEW_H
+#define PHIL_TEMPLATE_LIBRARY_NEW_H
+
+#include <cstddef>
+
+namespace ptl
+{
+	//C++17's std::hardware_destructive_interference_size is missing from a few standard libraries and gcc warns about using it in headers,
+	//as its value depends on compiler flags. 64 bytes is right for pretty much every x86 and most ARM cores, and merely wastes a little space elsewhere.
+	inline constexpr std::size_t hardware_destructive_interference_size=64;
+	inline constexpr std::size_t hardware_constructive_interference_size=64;
+
+} //end namespace ptl
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_PARALLEL_ALGORITHM_H
+#define PHIL_TEMPLATE_LIBRARY_PARALLEL_ALGORITHM_H
+
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/type_traits.hpp>
+
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+/***
+  Overloads of constexpr_algorithm::sort and stable_sort taking an execution policy, handed on to the standard parallel algorithms at runtime.
+  During constant evaluation the policy is ignored, as it is for ranges too small to be worth starting threads for.
+  Separate from constexpr_algorithm.hpp, as libstdc++ implements <execution> with TBB, which then has to be linked (-ltbb) by anyone including it.
+***/
+
+namespace ptl {
+namespace constexpr_algorithm
+{
+
+namespace detail
+{
+	template <typename POLICY_T>
+	using enable_if_execution_policy_t=::std::enable_if_t<::std::is_execution_policy_v<::std::decay_t<POLICY_T>>>;
+	
+	//roughly where the parallel versions start to win
+	constexpr ::std::ptrdiff_t parallel_threshold=1<<15;
+}
+
+template <typename POLICY_T, typename ITER_T, typename COMPARE_T, typename=detail::enable_if_execution_policy_t<POLICY_T>>
+constexpr void sort(POLICY_T&& policy, ITER_T first, ITER_T last, COMPARE_T compare)
+{
+	if(::ptl::is_constant_evaluated() || last-first<detail::parallel_threshold)
+		return ::ptl::constexpr_algorithm::sort(first,last,compare);
+	
+	::std::sort(::std::forward<POLICY_T>(policy),first,last,compare);
+}
+
+template <typename POLICY_T, typename ITER_T, typename=detail::enable_if_execution_policy_t<POLICY_T>>
+constexpr void sort(POLICY_T&& policy, ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm::sort(::std::forward<POLICY_T>(policy),first,last,::std::less<>{}); }
+
+template <typename POLICY_T, typename ITER_T, typename COMPARE_T, typename=detail::enable_if_execution_policy_t<POLICY_T>>
+constexpr void stable_sort(POLICY_T&& policy, ITER_T first, ITER_T last, COMPARE_T compare)
+{
+	if(::ptl::is_constant_evaluated() || last-first<detail::parallel_threshold)
+		return ::ptl::constexpr_algorithm::stable_sort(first,last,compare);
+	
+	::std::stable_sort(::std::forward<POLICY_T>(policy),first,last,compare);
+}
+
+template <typename POLICY_T, typename ITER_T, typename=detail::enable_if_execution_policy_t<POLICY_T>>
+constexpr void stable_sort(POLICY_T&& policy, ITER_T first, ITER_T last) { ::ptl::constexpr_algorithm::stable_sort(::std::forward<POLICY_T>(policy),first,last,::std::less<>{}); }
+
+}}
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_PERFECT_HASHMAP_H
+#define PHIL_TEMPLATE_LIBRARY_PERFECT_HASHMAP_H
+
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/constexpr_mersenne_twister.hpp>
+#include <ptl/ebo.hpp>
+
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+/***
+  An immutable hash map for static tables, built entirely at compile time.
+  Keys are distributed into buckets of about four keys each, then, starting with the largest, every bucket gets assigned the first
+  displacement value which sends all of its keys to still free slots (hash and displace, much like CHD).
+  The result is a minimal perfect hash: NUM keys in NUM slots, and a lookup is one hash, one displacement read and exactly one key comparison.
+  The seeds are drawn from the constexpr mersenne twister, whenever a seed turns out to be unusable we simply try the next one.
+***/
+
+namespace ptl
+{
+	namespace detail
+	{
+		//the splitmix64 finalizer, a bijection with good avalanche behaviour
+		constexpr std::uint64_t mix64(std::uint64_t x) noexcept
+		{
+			x=(x^(x>>30))*0xbf58476d1ce4e5b9ull;
+			x=(x^(x>>27))*0x94d049bb133111ebull;
+			return x^(x>>31);
+		}
+		
+		//maps x uniformly to [0,n) using the upper 32 bits of x and a multiplication instead of a division
+		constexpr std::size_t reduce_range(std::uint64_t x, std::size_t n) noexcept
+		{
+			return static_cast<std::size_t>(((x>>32)*n)>>32);
+		}
+	}
+	
+	template <typename T, typename = void>
+	struct seeded_hash;
+	
+	template <typename T>
+	struct seeded_hash<T,std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>>
+	{
+		constexpr std::uint64_t operator()(const T& value, std::uint64_t seed) const noexcept
+		{
+			if constexpr(std::is_enum_v<T>)
+				return detail::mix64(static_cast<std::uint64_t>(static_cast<std::underlying_type_t<T>>(value))^seed);
+			else
+				return detail::mix64(static_cast<std::uint64_t>(value)^seed);
+		}
+	};
+	
+	template <>
+	struct seeded_hash<std::string_view>
+	{
+		//seeded FNV-1a, followed by a final mix to spread the result over all bits
+		constexpr std::uint64_t operator()(std::string_view value, std::uint64_t seed) const noexcept
+		{
+			std::uint64_t hash=0xcbf29ce484222325ull^seed;
+			for(auto c: value)
+			{
+				hash^=static_cast<unsigned char>(c);
+				hash*=0x100000001b3ull;
+			}
+			return detail::mix64(hash);
+		}
+	};
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename HASH_T=seeded_hash<KEY_T>, typename KEY_EQUAL_T=std::equal_to<KEY_T>>
+	class fixed_perfect_hashmap: private ebo_bases<HASH_T,KEY_EQUAL_T>
+	{
+		public:
+		using key_type				=	KEY_T;
+		using mapped_type			=	MAPPED_T;
+		using value_type			=	std::pair<KEY_T,MAPPED_T>;
+		using size_type				=	std::size_t;
+		using difference_type		=	std::ptrdiff_t;
+		using hasher				=	HASH_T;
+		using key_equal				=	KEY_EQUAL_T;
+		
+		using reference				=	value_type&;
+		using const_reference		=	const value_type&;
+		
+		using iterator				=	typename std::array<value_type,NUM>::iterator;
+		using const_iterator		=	typename std::array<value_type,NUM>::const_iterator;
+		
+		static constexpr std::size_t bucket_count=NUM/4+1;
+		
+		constexpr explicit fixed_perfect_hashmap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM], const HASH_T& hash=HASH_T{}, const KEY_EQUAL_T& equal=KEY_EQUAL_T{}):
+			ebo_bases<HASH_T,KEY_EQUAL_T>{hash,equal}
+		{
+			ptl::mersenne_twister19937_64 seed_source{NUM};
+			for(std::size_t attempt=0;attempt<max_attempts;++attempt)
+			{
+				seed_=seed_source();
+				if(try_build(elements))
+					return;
+			}
+			
+			throw std::runtime_error{"Could not find a perfect hash for the given keys ;_;"};
+		}
+		
+		constexpr auto begin() noexcept { return entries_.begin(); }
+		constexpr auto begin() const noexcept { return entries_.begin(); }
+		constexpr auto end() noexcept { return entries_.end(); }
+		constexpr auto end() const noexcept { return entries_.end(); }
+		
+		constexpr auto cbegin() const noexcept { return begin(); }
+		constexpr auto cend() const noexcept { return end(); }
+		
+		constexpr auto empty() const noexcept { return NUM==0; }
+		constexpr auto size() const noexcept { return NUM; }
+		
+		constexpr auto find(const key_type& key)
+		{
+			return begin()+slot_of(key);
+		}
+		
+		constexpr auto find(const key_type& key) const
+		{
+			return begin()+slot_of(key);
+		}
+		
+		constexpr size_type count(const key_type& key) const
+		{
+			return slot_of(key)!=NUM?1:0;
+		}
+		
+		constexpr bool contains(const key_type& key) const
+		{
+			return count(key)!=0;
+		}
+		
+		constexpr auto& operator[](const key_type &key)
+		{
+			return access_impl(*this,key);
+		}
+		
+		constexpr const auto& operator[](const key_type &key) const
+		{
+			return access_impl(*this,key);
+		}
+		
+		constexpr hasher hash_function() const { return this->get_ebo_base(typelist<HASH_T>{}); }
+		constexpr key_equal key_eq() const { return this->get_ebo_base(typelist<KEY_EQUAL_T>{}); }
+		
+		private:
+		static constexpr std::size_t max_attempts=64;
+		static constexpr std::uint64_t displacement_multiplier=0x9e3779b97f4a7c15ull;
+		
+		std::array<value_type,NUM> entries_{};
+		std::array<std::uint32_t,bucket_count> displacements_{};
+		std::uint64_t seed_=0;
+		
+		constexpr static std::size_t bucket_of(std::uint64_t hash) noexcept
+		{
+			return detail::reduce_range(hash,bucket_count);
+		}
+		
+		constexpr static std::size_t slot_for(std::uint64_t hash, std::uint32_t displacement) noexcept
+		{
+			return detail::reduce_range(detail::mix64(hash+displacement*displacement_multiplier),NUM);
+		}
+		
+		//the single probe, returns NUM if the key is not in the map
+		constexpr std::size_t slot_of(const key_type& key) const
+		{
+			if constexpr(NUM==0)
+				return 0;
+			else
+			{
+				const auto hash=hash_function()(key,seed_);
+				const auto slot=slot_for(hash,displacements_[bucket_of(hash)]);
+				return key_eq()(entries_[slot].first,key)?slot:NUM;
+			}
+		}
+		
+		template <typename const_deduced_self>
+		constexpr static auto& access_impl(const_deduced_self& self, const key_type& key)
+		{
+			auto slot=self.slot_of(key);
+			if(slot==NUM)
+				throw std::out_of_range{"Tried to access nonexistent element with operator[] on an immutable map..."};
+			return self.entries_[slot].second;
+		}
+		
+		constexpr bool try_build(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+		{
+			displacements_={};
+			
+			std::array<std::uint64_t,NUM> hashes{};
+			for(std::size_t i=0;i<NUM;++i)
+				hashes[i]=hash_function()(elements[i].first,seed_);
+			
+			//counting sort of the keys by bucket, members[offsets[b]...offsets[b+1]) are the keys of bucket b
+			std::array<std::size_t,bucket_count+1> offsets{};
+			for(std::size_t i=0;i<NUM;++i)
+				++offsets[bucket_of(hashes[i])+1];
+			for(std::size_t b=0;b<bucket_count;++b)
+				offsets[b+1]+=offsets[b];
+			
+			std::array<std::size_t,NUM> members{};
+			auto next_member=offsets;
+			for(std::size_t i=0;i<NUM;++i)
+				members[next_member[bucket_of(hashes[i])]++]=i;
+			
+			std::array<std::size_t,bucket_count> order{};
+			for(std::size_t b=0;b<bucket_count;++b)
+				order[b]=b;
+			
+			const auto larger_bucket=[&](std::size_t lhs, std::size_t rhs)
+			{
+				return offsets[lhs+1]-offsets[lhs]>offsets[rhs+1]-offsets[rhs];
+			};
+			ptl::constexpr_algorithm::sort(std::begin(order),std::end(order),larger_bucket);
+			
+			std::array<bool,NUM> taken{};
+			std::array<std::size_t,NUM> candidate_slots{};
+			for(auto bucket: order)
+			{
+				const auto first=offsets[bucket];
+				const auto last=offsets[bucket+1];
+				if(first==last)
+					break;
+				
+				//no displacement can ever separate two keys with the same hash
+				for(auto i=first;i<last;++i)
+					for(auto j=i+1;j<last;++j)
+						if(hashes[members[i]]==hashes[members[j]])
+						{
+							if(key_eq()(elements[members[i]].first,elements[members[j]].first))
+								throw std::invalid_argument{"Duplicate key in perfect hashmap ;_;"};
+							return false;
+						}
+				
+				//with a single free slot left, finding it takes NUM tries on average, so this limit is practically never reached
+				const std::uint32_t max_displacement=16*NUM+64;
+				std::uint32_t displacement=0;
+				for(;displacement<max_displacement;++displacement)
+				{
+					bool fits=true;
+					for(auto i=first;i<last && fits;++i)
+					{
+						candidate_slots[i]=slot_for(hashes[members[i]],displacement);
+						fits=!taken[candidate_slots[i]];
+						for(auto j=first;j<i && fits;++j)
+							fits=candidate_slots[j]!=candidate_slots[i];
+					}
+					
+					if(fits)
+						break;
+				}
+				
+				if(displacement==max_displacement)
+					return false;
+				
+				displacements_[bucket]=displacement;
+				for(auto i=first;i<last;++i)
+				{
+					taken[candidate_slots[i]]=true;
+					//std::pair's assignment is not constexpr before C++20
+					entries_[candidate_slots[i]].first=elements[members[i]].first;
+					entries_[candidate_slots[i]].second=elements[members[i]].second;
+				}
+			}
+			
+			return true;
+		}
+	};
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename HASH_T, typename KEY_EQUAL_T=std::equal_to<KEY_T>>
+	constexpr auto make_fixed_perfect_hashmap(HASH_T hash, KEY_EQUAL_T equal, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return fixed_perfect_hashmap<KEY_T,MAPPED_T,NUM,HASH_T,KEY_EQUAL_T>{elements,hash,equal};
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM>
+	constexpr auto make_fixed_perfect_hashmap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return fixed_perfect_hashmap<KEY_T,MAPPED_T,NUM>{elements};
+	}
+
+} //end namespace ptl
+
+#endif
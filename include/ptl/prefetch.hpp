@@ -0,0 +1,25 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_PREFETCH_H
+#define PHIL_TEMPLATE_LIBRARY_PREFETCH_H
+
+#include <ptl/type_traits.hpp>
+
+namespace ptl
+{
+	//Purely a hint, so doing nothing is always correct. Which is exactly what happens during constant evaluation
+	//or on compilers not offering __builtin_prefetch.
+	template <typename T>
+	constexpr void prefetch(const T* ptr) noexcept
+	{
+		#ifdef __has_builtin
+		#if __has_builtin(__builtin_prefetch)
+		if(!ptl::is_constant_evaluated())
+			__builtin_prefetch(ptr);
+		#endif
+		#endif
+		
+		static_cast<void>(ptr);
+	}
+	
+} //end namespace ptl
+
+#endif
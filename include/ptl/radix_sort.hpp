@@ -0,0 +1,247 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_RADIX_SORT_H
+#define PHIL_TEMPLATE_LIBRARY_RADIX_SORT_H
+
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/handle.hpp>
+#include <ptl/uint_bits.hpp>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <climits>
+#include <cstddef>
+
+/***
+  Radix sorts for everything whose order is that of an integer: integral types, enums and ptl::handles,
+  either directly or as returned by a projection from the elements to their keys (think [](const auto& p) { return p.first; }).
+  Keys are mapped to unsigned integers of the same width (flipping the sign bit of signed ones) and sorted by DIGIT_BITS bits at a time.
+  radix_sort is a stable LSD sort through a buffer as large as the input, in linear time, which beats any comparison sort from a few hundred elements on.
+  Passes in which all keys share the same digit are skipped, so small keys in wide types (e.g. handles counting from 0) only cost the passes they need.
+  inplace_radix_sort is an MSD (American flag) sort without any allocation and constexpr, for compile time tables. It is not stable.
+***/
+
+namespace ptl
+{
+	struct radix_identity
+	{
+		template <typename T>
+		constexpr T&& operator()(T&& value) const noexcept { return std::forward<T>(value); }
+	};
+	
+	namespace detail
+	{
+		template <typename T>
+		constexpr auto radix_key(T value) noexcept
+		{
+			if constexpr(std::is_enum_v<T>)
+				return radix_key(static_cast<std::underlying_type_t<T>>(value));
+			else
+			{
+				static_assert(std::is_integral_v<T> && !std::is_same_v<T,bool>,"radix sort keys have to be integers, enums or handles ;_;");
+				
+				using unsigned_t=ptl::uint_bits_t<sizeof(T)*CHAR_BIT>;
+				if constexpr(std::is_signed_v<T>)
+					return static_cast<unsigned_t>(static_cast<unsigned_t>(value)^(unsigned_t{1}<<(sizeof(T)*CHAR_BIT-1)));
+				else
+					return static_cast<unsigned_t>(value);
+			}
+		}
+		
+		template <typename TAG_T, typename INTERNAL_T>
+		constexpr auto radix_key(const ptl::handle<TAG_T,INTERNAL_T>& value) noexcept
+		{
+			return radix_key(value.underlying());
+		}
+		
+		template <std::size_t DIGIT_BITS>
+		struct radix_digits
+		{
+			static_assert(DIGIT_BITS>0 && DIGIT_BITS<=16,"Digits need between 1 and 16 bits, or the counts do not fit in cache anymore");
+			
+			using digit_type=ptl::uint_least_bits_t<DIGIT_BITS>;
+			static constexpr std::size_t radix=std::size_t{1}<<DIGIT_BITS;
+			
+			template <typename KEY_T>
+			static constexpr std::size_t passes=(sizeof(KEY_T)*CHAR_BIT+DIGIT_BITS-1)/DIGIT_BITS;
+			
+			template <typename KEY_T>
+			static constexpr digit_type digit(KEY_T key, std::size_t pass) noexcept
+			{
+				return static_cast<digit_type>((key>>(pass*DIGIT_BITS))&(radix-1));
+			}
+		};
+		
+		template <typename PROJECTION_T>
+		struct radix_less
+		{
+			PROJECTION_T& projection;
+			
+			template <typename T>
+			constexpr bool operator()(const T& lhs, const T& rhs) const
+			{
+				return radix_key(projection(lhs))<radix_key(projection(rhs));
+			}
+		};
+		
+		template <std::size_t DIGIT_BITS, typename ITER_T, typename PROJECTION_T>
+		constexpr void american_flag_sort(ITER_T first, ITER_T last, PROJECTION_T& projection, std::size_t pass)
+		{
+			using digits=radix_digits<DIGIT_BITS>;
+			using difference_type=typename std::iterator_traits<ITER_T>::difference_type;
+			
+			constexpr difference_type insertion_sort_threshold=32;
+			
+			const auto digit_of=[&](const auto& value) { return digits::digit(radix_key(projection(value)),pass); };
+			for(;;)
+			{
+				const auto size=last-first;
+				if(size<=insertion_sort_threshold)
+				{
+					::ptl::constexpr_algorithm::detail::insertion_sort(first,last,radix_less<PROJECTION_T>{projection});
+					return;
+				}
+				
+				std::array<difference_type,digits::radix> counts{};
+				for(auto it=first;it!=last;++it)
+					++counts[digit_of(*it)];
+				
+				//all in one bucket, nothing to permute
+				if(counts[digit_of(*first)]!=size)
+				{
+					std::array<difference_type,digits::radix> heads{};
+					std::array<difference_type,digits::radix> tails{};
+					difference_type offset=0;
+					for(std::size_t bucket=0;bucket<digits::radix;++bucket)
+					{
+						heads[bucket]=offset;
+						offset+=counts[bucket];
+						tails[bucket]=offset;
+					}
+					
+					//swap each element straight into the next free slot of its bucket, until the one we got back belongs here
+					for(std::size_t bucket=0;bucket<digits::radix;++bucket)
+					{
+						while(heads[bucket]<tails[bucket])
+						{
+							for(std::size_t digit=digit_of(first[heads[bucket]]);digit!=bucket;digit=digit_of(first[heads[bucket]]))
+								::ptl::constexpr_algorithm::swap(first[heads[bucket]],first[heads[digit]++]);
+							++heads[bucket];
+						}
+					}
+					
+					if(pass==0)
+						return;
+					
+					difference_type bucket_first=0;
+					for(std::size_t bucket=0;bucket<digits::radix;++bucket)
+					{
+						if(counts[bucket]>1)
+							american_flag_sort<DIGIT_BITS>(first+bucket_first,first+bucket_first+counts[bucket],projection,pass-1);
+						bucket_first+=counts[bucket];
+					}
+					return;
+				}
+				
+				if(pass==0)
+					return;
+				--pass;
+			}
+		}
+		
+		template <typename DIGITS_T, typename SOURCE_ITER_T, typename DEST_ITER_T, typename COUNTS_T, typename PROJECTION_T>
+		void radix_scatter(SOURCE_ITER_T first, SOURCE_ITER_T last, DEST_ITER_T dest, const COUNTS_T& counts, std::size_t pass, PROJECTION_T& projection)
+		{
+			std::array<std::size_t,DIGITS_T::radix> offsets;
+			std::size_t offset=0;
+			for(std::size_t bucket=0;bucket<DIGITS_T::radix;++bucket)
+			{
+				offsets[bucket]=offset;
+				offset+=counts[bucket];
+			}
+			
+			for(;first!=last;++first)
+				dest[offsets[DIGITS_T::digit(radix_key(projection(*first)),pass)]++]=std::move(*first);
+		}
+	}
+	
+	//Stable LSD radix sort. Needs random access iterators and allocates a buffer for all elements.
+	template <std::size_t DIGIT_BITS=8, typename ITER_T, typename PROJECTION_T=radix_identity>
+	void radix_sort(ITER_T first, ITER_T last, PROJECTION_T projection=PROJECTION_T{})
+	{
+		static_assert(std::is_convertible_v<typename std::iterator_traits<ITER_T>::iterator_category,std::random_access_iterator_tag>,"radix_sort requires random access iterators ;_;");
+		
+		using value_type=typename std::iterator_traits<ITER_T>::value_type;
+		using key_type=decltype(detail::radix_key(projection(*first)));
+		using digits=detail::radix_digits<DIGIT_BITS>;
+		constexpr auto passes=digits::template passes<key_type>;
+		
+		//counting and scattering does not pay off for a handful of elements
+		constexpr std::ptrdiff_t comparison_sort_threshold=64;
+		
+		const auto size=static_cast<std::size_t>(last-first);
+		if(static_cast<std::ptrdiff_t>(size)<comparison_sort_threshold)
+		{
+			std::stable_sort(first,last,detail::radix_less<PROJECTION_T>{projection});
+			return;
+		}
+		
+		//the histograms for all passes in a single read of the input
+		std::vector<std::array<std::size_t,digits::radix>> counts(passes);
+		for(auto it=first;it!=last;++it)
+		{
+			const auto key=detail::radix_key(projection(*it));
+			for(std::size_t pass=0;pass<passes;++pass)
+				++counts[pass][digits::digit(key,pass)];
+		}
+		
+		const auto first_key=detail::radix_key(projection(*first));
+		std::array<bool,passes> needed{};
+		bool any_needed=false;
+		for(std::size_t pass=0;pass<passes;++pass)
+		{
+			needed[pass]=counts[pass][digits::digit(first_key,pass)]!=size;
+			any_needed|=needed[pass];
+		}
+		
+		if(!any_needed)
+			return;
+		
+		//the buffer starts out with the elements, so they do not need to be default constructible
+		std::vector<value_type> buffer(std::make_move_iterator(first),std::make_move_iterator(last));
+		bool in_buffer=true;
+		for(std::size_t pass=0;pass<passes;++pass)
+		{
+			if(!needed[pass])
+				continue;
+			
+			if(in_buffer)
+				detail::radix_scatter<digits>(std::begin(buffer),std::end(buffer),first,counts[pass],pass,projection);
+			else
+				detail::radix_scatter<digits>(first,last,std::begin(buffer),counts[pass],pass,projection);
+			in_buffer=!in_buffer;
+		}
+		
+		if(in_buffer)
+			std::move(std::begin(buffer),std::end(buffer),first);
+	}
+	
+	//Unstable in-place MSD radix sort, constexpr and without allocations.
+	template <std::size_t DIGIT_BITS=8, typename ITER_T, typename PROJECTION_T=radix_identity>
+	constexpr void inplace_radix_sort(ITER_T first, ITER_T last, PROJECTION_T projection=PROJECTION_T{})
+	{
+		static_assert(std::is_convertible_v<typename std::iterator_traits<ITER_T>::iterator_category,std::random_access_iterator_tag>,"inplace_radix_sort requires random access iterators ;_;");
+		
+		if(last-first<2)
+			return;
+		
+		using key_type=decltype(detail::radix_key(projection(*first)));
+		detail::american_flag_sort<DIGIT_BITS>(first,last,projection,detail::radix_digits<DIGIT_BITS>::template passes<key_type>-1);
+	}
+
+} //end namespace ptl
+
+#endif
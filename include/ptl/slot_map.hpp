@@ -0,0 +1,198 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_SLOT_MAP_H
+#define PHIL_TEMPLATE_LIBRARY_SLOT_MAP_H
+
+#include <ptl/handle.hpp>
+#include <ptl/uint_bits.hpp>
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/***
+  Storage for objects referred to by ptl::handles, with constant time insertion, erasure and lookup and no hashing anywhere.
+  A handle packs the index of a slot (lower half of its bits) and the generation of that slot (upper half) at the time it was handed out.
+  Slots point to the values, which are kept densely packed in a vector for iteration, erasure moving the last value into the gap.
+  Erasing bumps the slot's generation, so handles to erased values are recognized as stale, even once the slot has been reused.
+  A slot whose generation would wrap around is retired instead of reused, so no stale handle can ever become valid again.
+***/
+
+namespace ptl
+{
+	template <typename T, typename TAG_T, typename INTERNAL_T=std::uint64_t>
+	class slot_map
+	{
+		static_assert(std::is_unsigned_v<INTERNAL_T> && std::numeric_limits<INTERNAL_T>::digits>=16,"slot_map handles need an unsigned integer of at least 16 bits ;_;");
+		
+		static constexpr std::size_t index_bits=std::numeric_limits<INTERNAL_T>::digits/2;
+		
+		public:
+		using value_type		=	T;
+		using handle_type		=	ptl::handle<TAG_T,INTERNAL_T>;
+		using reference			=	value_type&;
+		using const_reference	=	const value_type&;
+		using iterator			=	typename std::vector<T>::iterator;
+		using const_iterator	=	typename std::vector<T>::const_iterator;
+		using size_type			=	std::size_t;
+		using index_type		=	ptl::uint_bits_t<index_bits>;
+		using generation_type	=	ptl::uint_bits_t<index_bits>;
+		
+		template <typename... ARGS>
+		handle_type emplace(ARGS&&... args)
+		{
+			const auto slot_index=acquire_slot();
+			
+			//nothing changes if constructing the value throws, apart from maybe an extra free slot
+			values_.emplace_back(std::forward<ARGS>(args)...);
+			value_slots_.push_back(slot_index);
+			
+			auto& slot=slots_[slot_index];
+			free_head_=slot.index;
+			slot.index=static_cast<index_type>(values_.size()-1);
+			slot.occupied=true;
+			return make_handle(slot_index,slot.generation);
+		}
+		
+		handle_type insert(const T& value) { return emplace(value); }
+		handle_type insert(T&& value) { return emplace(std::move(value)); }
+		
+		//false if the handle was stale already
+		bool erase(handle_type handle)
+		{
+			const auto slot_index=index_of(handle);
+			if(!contains(handle))
+				return false;
+			
+			auto& slot=slots_[slot_index];
+			const auto position=slot.index;
+			if(position!=values_.size()-1)
+			{
+				values_[position]=std::move(values_.back());
+				value_slots_[position]=value_slots_.back();
+				slots_[value_slots_[position]].index=position;
+			}
+			values_.pop_back();
+			value_slots_.pop_back();
+			
+			release_slot(slot_index);
+			return true;
+		}
+		
+		bool contains(handle_type handle) const noexcept
+		{
+			const auto slot_index=index_of(handle);
+			return slot_index<slots_.size() && slots_[slot_index].generation==generation_of(handle) && slots_[slot_index].occupied;
+		}
+		
+		//nullptr for stale handles
+		T* find(handle_type handle) noexcept { return contains(handle)?&values_[slots_[index_of(handle)].index]:nullptr; }
+		const T* find(handle_type handle) const noexcept { return contains(handle)?&values_[slots_[index_of(handle)].index]:nullptr; }
+		
+		//unchecked, the handle has to be valid
+		reference operator[](handle_type handle) noexcept { return values_[slots_[index_of(handle)].index]; }
+		const_reference operator[](handle_type handle) const noexcept { return values_[slots_[index_of(handle)].index]; }
+		
+		#if __cpp_exceptions
+		reference at(handle_type handle) { if(!contains(handle)) throw std::out_of_range{"Accessed slot_map with a stale handle ;_;"}; return (*this)[handle]; }
+		const_reference at(handle_type handle) const { if(!contains(handle)) throw std::out_of_range{"Accessed slot_map with a stale handle ;_;"}; return (*this)[handle]; }
+		#endif
+		
+		//the handle of the value at the given position in iteration order, e.g. handle_at(it-begin())
+		handle_type handle_at(size_type position) const noexcept
+		{
+			const auto slot_index=value_slots_[position];
+			return make_handle(slot_index,slots_[slot_index].generation);
+		}
+		
+		size_type size() const noexcept { return values_.size(); }
+		bool empty() const noexcept { return values_.empty(); }
+		size_type capacity() const noexcept { return values_.capacity(); }
+		
+		//the most values there can be at once, as a handle has only so many bits for the index
+		static constexpr size_type max_size() noexcept { return std::numeric_limits<index_type>::max(); }
+		
+		void reserve(size_type count)
+		{
+			values_.reserve(count);
+			value_slots_.reserve(count);
+			slots_.reserve(count);
+		}
+		
+		//invalidates all handles
+		void clear() noexcept
+		{
+			for(const auto slot_index: value_slots_)
+				release_slot(slot_index);
+			values_.clear();
+			value_slots_.clear();
+		}
+		
+		//the values, densely packed and in no particular order. Erasing moves the last one in place of the erased one.
+		T* data() noexcept { return values_.data(); }
+		const T* data() const noexcept { return values_.data(); }
+		
+		iterator begin() noexcept { return values_.begin(); }
+		const_iterator begin() const noexcept { return values_.begin(); }
+		const_iterator cbegin() const noexcept { return values_.cbegin(); }
+		
+		iterator end() noexcept { return values_.end(); }
+		const_iterator end() const noexcept { return values_.end(); }
+		const_iterator cend() const noexcept { return values_.cend(); }
+		
+		private:
+		//index points to the value while occupied and to the next free slot otherwise
+		struct slot
+		{
+			index_type index;
+			generation_type generation;
+			bool occupied;
+		};
+		
+		static constexpr index_type no_slot=std::numeric_limits<index_type>::max();
+		
+		static constexpr index_type index_of(handle_type handle) noexcept { return static_cast<index_type>(handle.underlying()); }
+		static constexpr generation_type generation_of(handle_type handle) noexcept { return static_cast<generation_type>(handle.underlying()>>index_bits); }
+		
+		static constexpr handle_type make_handle(index_type slot_index, generation_type generation) noexcept
+		{
+			return handle_type{static_cast<INTERNAL_T>(static_cast<INTERNAL_T>(generation)<<index_bits|slot_index)};
+		}
+		
+		//Returns a free slot, still linked into the free list, for emplace to take out once the value exists
+		index_type acquire_slot()
+		{
+			if(free_head_!=no_slot)
+				return free_head_;
+			
+			if(slots_.size()>=max_size())
+				throw std::length_error{"slot_map ran out of slots ;_;"};
+			
+			slots_.push_back({no_slot,0,false});
+			free_head_=static_cast<index_type>(slots_.size()-1);
+			return free_head_;
+		}
+		
+		void release_slot(index_type slot_index) noexcept
+		{
+			auto& slot=slots_[slot_index];
+			slot.occupied=false;
+			if(slot.generation==std::numeric_limits<generation_type>::max())
+				return;
+			
+			++slot.generation;
+			slot.index=free_head_;
+			free_head_=slot_index;
+		}
+		
+		std::vector<T> values_;
+		std::vector<index_type> value_slots_;
+		std::vector<slot> slots_;
+		index_type free_head_=no_slot;
+	};
+}
+
+#endif
@@ -0,0 +1,456 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_SMALL_VECTOR_H
+#define PHIL_TEMPLATE_LIBRARY_SMALL_VECTOR_H
+
+#include <ptl/fixed_capacity_vector.hpp>
+#include <ptl/type_traits.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+namespace ptl
+{
+	namespace detail
+	{
+		//Same interface as the fixed_capacity storages, so the gap functions work on it as well
+		template <typename T>
+		struct small_vector_heap
+		{
+			template <typename... ARGS>
+			void construct_at(std::size_t pos, ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+			{
+				::new(static_cast<void*>(data+pos)) T(std::forward<ARGS>(args)...);
+			}
+			
+			void destroy_at(std::size_t pos) noexcept(std::is_nothrow_destructible_v<T>)
+			{
+				data[pos].~T();
+			}
+			
+			T* data_ptr() noexcept { return data; }
+			const T* data_ptr() const noexcept { return data; }
+			
+			T* data=nullptr;
+			std::size_t used=0;
+			std::size_t capacity=0;
+		};
+		
+		//Moves count elements into uninitialized memory and destroys the originals. noexcept for the same reason as open_gap.
+		template <typename T>
+		void relocate_n(T* source, std::size_t count, T* dest) noexcept
+		{
+			if constexpr(ptl::is_trivially_relocatable_v<T>)
+				move_bytes(dest,source,count);
+			else
+			{
+				for(std::size_t i=0;i<count;++i)
+				{
+					::new(static_cast<void*>(dest+i)) T(std::move(source[i]));
+					source[i].~T();
+				}
+			}
+		}
+	}
+	
+	//A vector keeping up to N elements inline, in the same storage fixed_capacity_vector uses, and only allocating once it outgrows them.
+	//Once on the heap, it stays there until shrink_to_fit finds it fits inline again.
+	template <typename T, std::size_t N>
+	class small_vector
+	{
+		//see fixed_capacity_vector for why this comes first
+		private:
+		//only ever one of them holds elements, heap_ whenever its data is not null
+		detail::small_vector_heap<T> heap_;
+		detail::fixed_capacity_storage<T,N> inline_;
+		
+		public:
+		using value_type		=	T;
+		using reference			=	value_type&;
+		using const_reference	=	const value_type&;
+		using pointer			=	T*;
+		using const_pointer		=	const T*;
+		using iterator			=	pointer;
+		using const_iterator	=	const_pointer;
+		using size_type			=	std::size_t;
+		using difference_type	=	std::ptrdiff_t;
+		
+		small_vector() noexcept = default;
+		
+		explicit small_vector(size_type count) { resize(count); }
+		small_vector(size_type count, const_reference value) { assign(count,value); }
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		small_vector(ITER_T first, ITER_T last) { assign(first,last); }
+		
+		small_vector(std::initializer_list<T> values) { assign(values); }
+		
+		small_vector(const small_vector& other)
+		{
+			copy_from(other);
+		}
+		
+		small_vector(small_vector&& other) noexcept
+		{
+			move_from(other);
+		}
+		
+		~small_vector() noexcept
+		{
+			clear();
+			release_heap();
+		}
+		
+		small_vector& operator=(const small_vector& other)
+		{
+			if(this!=&other)
+			{
+				clear();
+				copy_from(other);
+			}
+			return *this;
+		}
+		
+		small_vector& operator=(small_vector&& other) noexcept
+		{
+			if(this!=&other)
+			{
+				clear();
+				if(other.on_heap())
+					release_heap();
+				move_from(other);
+			}
+			return *this;
+		}
+		
+		small_vector& operator=(std::initializer_list<T> values)
+		{
+			assign(values);
+			return *this;
+		}
+		
+		size_type size() const noexcept { return on_heap()?heap_.used:inline_.used; }
+		bool empty() const noexcept { return size()==0; }
+		size_type capacity() const noexcept { return on_heap()?heap_.capacity:N; }
+		size_type max_size() const noexcept { return std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>{}); }
+		static constexpr size_type inline_capacity() noexcept { return N; }
+		bool is_inline() const noexcept { return !on_heap(); }
+		
+		reference operator[](size_type id) noexcept { return data()[id]; }
+		const_reference operator[](size_type id) const noexcept { return data()[id]; }
+		
+		#if __cpp_exceptions
+		reference at(size_type id) { if(!(id<size())) throw std::out_of_range{"Accessed small_vector out of range ;_;"}; return data()[id]; }
+		const_reference at(size_type id) const { if(!(id<size())) throw std::out_of_range{"Accessed small_vector out of range ;_;"}; return data()[id]; }
+		#endif
+		
+		reference front() noexcept { return data()[0]; }
+		const_reference front() const noexcept { return data()[0]; }
+		
+		reference back() noexcept { return data()[size()-1]; }
+		const_reference back() const noexcept { return data()[size()-1]; }
+		
+		pointer data() noexcept { return on_heap()?heap_.data:inline_.data_ptr(); }
+		const_pointer data() const noexcept { return on_heap()?heap_.data:inline_.data_ptr(); }
+		
+		auto begin() noexcept { return data(); }
+		auto begin() const noexcept { return data(); }
+		auto cbegin() const noexcept { return data(); }
+		
+		auto rbegin() noexcept { return std::make_reverse_iterator(end()); }
+		auto rbegin() const noexcept { return std::make_reverse_iterator(end()); }
+		auto crbegin() const noexcept { return std::make_reverse_iterator(end()); }
+		
+		auto end() noexcept { return data()+size(); }
+		auto end() const noexcept { return data()+size(); }
+		auto cend() const noexcept { return data()+size(); }
+		
+		auto rend() noexcept { return std::make_reverse_iterator(begin()); }
+		auto rend() const noexcept { return std::make_reverse_iterator(begin()); }
+		auto crend() const noexcept { return std::make_reverse_iterator(begin()); }
+		
+		void reserve(size_type new_capacity)
+		{
+			if(new_capacity>capacity())
+				reallocate(new_capacity);
+		}
+		
+		void shrink_to_fit()
+		{
+			if(!on_heap() || size()==capacity())
+				return;
+			
+			if(size()<=N)
+			{
+				const auto count=size();
+				detail::relocate_n(heap_.data,count,inline_.data_ptr());
+				heap_.used=0;
+				release_heap();
+				inline_.used=static_cast<decltype(inline_.used)>(count);
+			}
+			else
+				reallocate(size());
+		}
+		
+		void clear() noexcept
+		{
+			if(on_heap())
+			{
+				std::destroy_n(heap_.data,heap_.used);
+				heap_.used=0;
+			}
+			else
+				inline_.clear();
+		}
+		
+		void push_back(const_reference value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+		
+		template <typename... ARGS>
+		reference emplace_back(ARGS&&... args)
+		{
+			if(size()==capacity())
+			{
+				//constructed before reallocating, as the arguments might refer to our own elements
+				T value(std::forward<ARGS>(args)...);
+				reallocate(grown_capacity(size()+1));
+				return construct_back(std::move(value));
+			}
+			return construct_back(std::forward<ARGS>(args)...);
+		}
+		
+		void pop_back() noexcept(std::is_nothrow_destructible_v<T>)
+		{
+			visit([](auto& storage) { --storage.used; storage.destroy_at(storage.used); });
+		}
+		
+		template <typename... ARGS>
+		iterator emplace(const_iterator position, ARGS&&... args)
+		{
+			const auto pos=index_of(position);
+			if(pos==size())
+			{
+				emplace_back(std::forward<ARGS>(args)...);
+				return begin()+pos;
+			}
+			
+			T value(std::forward<ARGS>(args)...);
+			make_room(1);
+			visit([&](auto& storage)
+			{
+				detail::open_gap<T>(storage,pos,1);
+				storage.construct_at(pos,std::move(value));
+				++storage.used;
+			});
+			return begin()+pos;
+		}
+		
+		iterator insert(const_iterator position, const_reference value) { return emplace(position,value); }
+		iterator insert(const_iterator position, T&& value) { return emplace(position,std::move(value)); }
+		
+		iterator insert(const_iterator position, size_type count, const_reference value)
+		{
+			const auto pos=index_of(position);
+			if(count==0)
+				return begin()+pos;
+			
+			const T copy(value);
+			make_room(count);
+			visit([&](auto& storage)
+			{
+				detail::open_gap<T>(storage,pos,count);
+				for(std::size_t i=0;i<count;++i)
+					storage.construct_at(pos+i,copy);
+				storage.used+=count;
+			});
+			return begin()+pos;
+		}
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		iterator insert(const_iterator position, ITER_T first, ITER_T last)
+		{
+			const auto pos=index_of(position);
+			if constexpr(detail::is_forward_iterator<ITER_T>)
+			{
+				const auto count=static_cast<std::size_t>(std::distance(first,last));
+				if(count==0)
+					return begin()+pos;
+				
+				make_room(count);
+				visit([&](auto& storage)
+				{
+					detail::open_gap<T>(storage,pos,count);
+					for(std::size_t i=0;i<count;++i,++first)
+						storage.construct_at(pos+i,*first);
+					storage.used+=count;
+				});
+			}
+			else
+			{
+				for(auto it=begin()+pos;first!=last;++first,++it)
+					it=emplace(it,*first);
+			}
+			return begin()+pos;
+		}
+		
+		iterator insert(const_iterator position, std::initializer_list<T> values) { return insert(position,values.begin(),values.end()); }
+		
+		iterator erase(const_iterator position) { return erase(position,position+1); }
+		
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			const auto pos=index_of(first);
+			const auto count=index_of(last)-pos;
+			if(count==0)
+				return begin()+pos;
+			
+			visit([&](auto& storage)
+			{
+				for(std::size_t i=0;i<count;++i)
+					storage.destroy_at(pos+i);
+				detail::close_gap<T>(storage,pos,count);
+				storage.used-=count;
+			});
+			return begin()+pos;
+		}
+		
+		void resize(size_type count)
+		{
+			shrink_to(count);
+			reserve(count);
+			while(size()<count)
+				construct_back();
+		}
+		
+		void resize(size_type count, const_reference value)
+		{
+			if(count>size())
+				insert(end(),count-size(),value);
+			else
+				shrink_to(count);
+		}
+		
+		void assign(size_type count, const_reference value)
+		{
+			clear();
+			insert(end(),count,value);
+		}
+		
+		template <typename ITER_T, typename = detail::enable_if_input_iterator_t<ITER_T>>
+		void assign(ITER_T first, ITER_T last)
+		{
+			clear();
+			insert(end(),first,last);
+		}
+		
+		void assign(std::initializer_list<T> values) { assign(values.begin(),values.end()); }
+		
+		void swap(small_vector& other) noexcept
+		{
+			if(on_heap() && other.on_heap())
+			{
+				std::swap(heap_,other.heap_);
+				return;
+			}
+			
+			small_vector temporary(std::move(other));
+			other=std::move(*this);
+			*this=std::move(temporary);
+		}
+		
+		friend void swap(small_vector& lhs, small_vector& rhs) noexcept { lhs.swap(rhs); }
+		
+		private:
+		bool on_heap() const noexcept { return heap_.data!=nullptr; }
+		
+		template <typename FUNCTION_T>
+		void visit(FUNCTION_T&& function)
+		{
+			if(on_heap())
+				function(heap_);
+			else
+				function(inline_);
+		}
+		
+		size_type index_of(const_iterator position) const noexcept { return static_cast<size_type>(position-cbegin()); }
+		
+		size_type grown_capacity(size_type needed) const noexcept { return std::max(needed,capacity()*2); }
+		
+		void make_room(size_type count)
+		{
+			if(size()+count>capacity())
+				reallocate(grown_capacity(size()+count));
+		}
+		
+		//capacity has to suffice
+		template <typename... ARGS>
+		reference construct_back(ARGS&&... args)
+		{
+			visit([&](auto& storage) { storage.construct_at(storage.used,std::forward<ARGS>(args)...); ++storage.used; });
+			return back();
+		}
+		
+		void shrink_to(size_type count) noexcept
+		{
+			while(size()>count)
+				pop_back();
+		}
+		
+		void reallocate(size_type new_capacity)
+		{
+			std::allocator<T> allocator;
+			T* new_data=allocator.allocate(new_capacity);
+			
+			const auto count=size();
+			detail::relocate_n(data(),count,new_data);
+			inline_.used=0;
+			heap_.used=0;
+			release_heap();
+			
+			heap_={new_data,count,new_capacity};
+		}
+		
+		void release_heap() noexcept
+		{
+			if(on_heap())
+				std::allocator<T>{}.deallocate(heap_.data,heap_.capacity);
+			heap_={};
+		}
+		
+		//expects to be empty
+		void copy_from(const small_vector& other)
+		{
+			reserve(other.size());
+			visit([&](auto& storage)
+			{
+				std::uninitialized_copy(other.begin(),other.end(),storage.data_ptr());
+				storage.used=static_cast<decltype(storage.used)>(other.size());
+			});
+		}
+		
+		//expects to be empty, and no longer on the heap if other is
+		void move_from(small_vector& other) noexcept
+		{
+			if(other.on_heap())
+			{
+				heap_=other.heap_;
+				other.heap_={};
+			}
+			else if(on_heap())
+			{
+				detail::relocate_n(other.inline_.data_ptr(),other.inline_.used,heap_.data);
+				heap_.used=other.inline_.used;
+				other.inline_.used=0;
+			}
+			else
+				inline_.move_from(other.inline_);
+		}
+	};
+}
+
+#endif
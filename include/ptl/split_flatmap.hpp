@@ -0,0 +1,338 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_SPLIT_FLATMAP_H
+#define PHIL_TEMPLATE_LIBRARY_SPLIT_FLATMAP_H
+
+#include <ptl/constexpr_algorithm.hpp>
+#include <ptl/ebo.hpp>
+#include <ptl/flatmap.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/***
+  Same idea as flatmap, but keys and mapped values live in two separate, parallel containers.
+  Binary searches only ever touch the keys, so large mapped types no longer drag themselves through the cache on every lookup.
+  Dereferencing an iterator yields a std::pair of references instead of a reference to a std::pair, similar to what zip iterators do.
+***/
+
+namespace ptl
+{
+	namespace detail
+	{
+		template <typename REFERENCE_T>
+		struct arrow_proxy
+		{
+			REFERENCE_T ref;
+			constexpr REFERENCE_T* operator->() noexcept { return &ref; }
+		};
+		
+		template <typename KEY_ITER_T, typename MAPPED_ITER_T>
+		class split_iterator
+		{
+			public:
+			using iterator_category	=	std::random_access_iterator_tag;
+			using difference_type	=	typename std::iterator_traits<KEY_ITER_T>::difference_type;
+			using value_type		=	std::pair<typename std::iterator_traits<KEY_ITER_T>::value_type,typename std::iterator_traits<MAPPED_ITER_T>::value_type>;
+			using reference			=	std::pair<const typename std::iterator_traits<KEY_ITER_T>::value_type&,typename std::iterator_traits<MAPPED_ITER_T>::reference>;
+			using pointer			=	arrow_proxy<reference>;
+			
+			constexpr split_iterator() = default;
+			
+			constexpr split_iterator(KEY_ITER_T key_it, MAPPED_ITER_T mapped_it):
+				key_it_{key_it},
+				mapped_it_{mapped_it}
+			{}
+			
+			//iterator to const_iterator
+			template <typename OTHER_KEY_ITER_T, typename OTHER_MAPPED_ITER_T, typename = std::enable_if_t<std::is_convertible_v<OTHER_MAPPED_ITER_T,MAPPED_ITER_T>>>
+			constexpr split_iterator(const split_iterator<OTHER_KEY_ITER_T,OTHER_MAPPED_ITER_T>& other):
+				key_it_{other.key_iterator()},
+				mapped_it_{other.mapped_iterator()}
+			{}
+			
+			constexpr KEY_ITER_T key_iterator() const noexcept { return key_it_; }
+			constexpr MAPPED_ITER_T mapped_iterator() const noexcept { return mapped_it_; }
+			
+			constexpr reference operator*() const { return reference{*key_it_,*mapped_it_}; }
+			constexpr pointer operator->() const { return pointer{**this}; }
+			constexpr reference operator[](difference_type n) const { return *(*this+n); }
+			
+			constexpr split_iterator& operator++() { ++key_it_; ++mapped_it_; return *this; }
+			constexpr split_iterator& operator--() { --key_it_; --mapped_it_; return *this; }
+			constexpr split_iterator operator++(int) { auto ret_val=*this; ++*this; return ret_val; }
+			constexpr split_iterator operator--(int) { auto ret_val=*this; --*this; return ret_val; }
+			
+			constexpr split_iterator& operator+=(difference_type n) { key_it_+=n; mapped_it_+=n; return *this; }
+			constexpr split_iterator& operator-=(difference_type n) { key_it_-=n; mapped_it_-=n; return *this; }
+			
+			friend constexpr split_iterator operator+(split_iterator it, difference_type n) { return it+=n; }
+			friend constexpr split_iterator operator+(difference_type n, split_iterator it) { return it+=n; }
+			friend constexpr split_iterator operator-(split_iterator it, difference_type n) { return it-=n; }
+			friend constexpr difference_type operator-(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_-rhs.key_it_; }
+			
+			friend constexpr bool operator==(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_==rhs.key_it_; }
+			friend constexpr bool operator!=(const split_iterator& lhs, const split_iterator& rhs) { return !(lhs==rhs); }
+			friend constexpr bool operator<(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_<rhs.key_it_; }
+			friend constexpr bool operator<=(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_<=rhs.key_it_; }
+			friend constexpr bool operator>(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_>rhs.key_it_; }
+			friend constexpr bool operator>=(const split_iterator& lhs, const split_iterator& rhs) { return lhs.key_it_>=rhs.key_it_; }
+			
+			private:
+			KEY_ITER_T key_it_{};
+			MAPPED_ITER_T mapped_it_{};
+		};
+	}
+	
+	template
+	<
+		typename KEY_T, typename MAPPED_T, typename COMPARE_T=std::less<KEY_T>,
+		typename KEY_CONTAINER_T=std::vector<KEY_T>, typename MAPPED_CONTAINER_T=std::vector<MAPPED_T>
+	>
+	class split_flatmap
+	{
+		public:
+		using key_type					=	KEY_T;
+		using mapped_type				=	MAPPED_T;
+		using value_type				=	std::pair<KEY_T,MAPPED_T>;
+		using size_type					=	typename KEY_CONTAINER_T::size_type;
+		using difference_type			=	typename KEY_CONTAINER_T::difference_type;
+		using key_compare				=	COMPARE_T;
+		
+		using key_container_type		=	KEY_CONTAINER_T;
+		using mapped_container_type		=	MAPPED_CONTAINER_T;
+		
+		using iterator					=	detail::split_iterator<typename KEY_CONTAINER_T::const_iterator,typename MAPPED_CONTAINER_T::iterator>;
+		using const_iterator			=	detail::split_iterator<typename KEY_CONTAINER_T::const_iterator,typename MAPPED_CONTAINER_T::const_iterator>;
+		using reverse_iterator			=	std::reverse_iterator<iterator>;
+		using const_reverse_iterator	=	std::reverse_iterator<const_iterator>;
+		
+		using reference					=	typename iterator::reference;
+		using const_reference			=	typename const_iterator::reference;
+		
+		constexpr split_flatmap():
+			split_flatmap(COMPARE_T{})
+		{}
+		
+		explicit constexpr split_flatmap(const COMPARE_T &comp):
+			data_{comp,KEY_CONTAINER_T{},MAPPED_CONTAINER_T{}}
+		{}
+		
+		//both containers have to be of the same size, with the keys already sorted and unique
+		constexpr split_flatmap(sorted_unique_t, const COMPARE_T &comp, KEY_CONTAINER_T keys, MAPPED_CONTAINER_T values):
+			data_{comp,std::move(keys),std::move(values)}
+		{}
+		
+		template <typename ITER_T, typename = typename std::iterator_traits<ITER_T>::iterator_category>
+		constexpr split_flatmap(ITER_T first, ITER_T last, const COMPARE_T &comp=COMPARE_T{}):
+			split_flatmap(comp)
+		{
+			insert(first,last);
+		}
+		
+		constexpr split_flatmap(std::initializer_list<value_type> values, const COMPARE_T &comp=COMPARE_T{}):
+			split_flatmap(values.begin(),values.end(),comp)
+		{}
+		
+		constexpr auto begin() noexcept { return iterator{std::cbegin(data_.keys),std::begin(data_.values)}; }
+		constexpr auto begin() const noexcept { return const_iterator{std::cbegin(data_.keys),std::cbegin(data_.values)}; }
+		constexpr auto end() noexcept { return iterator{std::cend(data_.keys),std::end(data_.values)}; }
+		constexpr auto end() const noexcept { return const_iterator{std::cend(data_.keys),std::cend(data_.values)}; }
+		
+		constexpr auto rbegin() noexcept { return reverse_iterator{end()}; }
+		constexpr auto rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		constexpr auto rend() noexcept { return reverse_iterator{begin()}; }
+		constexpr auto rend() const noexcept { return const_reverse_iterator{begin()}; }
+		
+		constexpr auto cbegin() const noexcept { return begin(); }
+		constexpr auto cend() const noexcept { return end(); }
+		constexpr auto crbegin() const noexcept { return rbegin(); }
+		constexpr auto crend() const noexcept { return rend(); }
+		
+		constexpr auto empty() const noexcept { return data_.keys.empty(); }
+		constexpr auto size() const noexcept { return data_.keys.size(); }
+		
+		constexpr const KEY_CONTAINER_T& keys() const noexcept { return data_.keys; }
+		constexpr const MAPPED_CONTAINER_T& values() const noexcept { return data_.values; }
+		
+		constexpr auto find(const key_type& key)
+		{
+			return find_impl(*this,key);
+		}
+		
+		constexpr auto find(const key_type& key) const
+		{
+			return find_impl(*this,key);
+		}
+		
+		constexpr std::pair<iterator, bool> insert(const value_type &new_val)
+		{
+			auto it=key_lower_bound(new_val.first);
+			const auto pos=it-std::cbegin(data_.keys);
+			if(it!=std::cend(data_.keys) && equal(*it,new_val.first))
+				return std::pair<iterator, bool>(begin()+pos,false);
+			
+			data_.keys.insert(it,new_val.first);
+			data_.values.insert(std::cbegin(data_.values)+pos,new_val.second);
+			return std::pair<iterator, bool>(begin()+pos,true);
+		}
+		
+		//Same semantics as flatmap's range insert: existing elements and the first of several equal new ones win.
+		//The new elements are sorted on their own, the ones already present are filtered out and the rest is merged
+		//backwards into both containers, moving every old element at most once.
+		template <typename ITER_T>
+		constexpr void insert(ITER_T first, ITER_T last)
+		{
+			std::vector<value_type> new_values(first,last);
+			
+			const auto compare_first=[&](const value_type& lhs, const value_type& rhs) { return key_comp()(lhs.first,rhs.first); };
+			std::stable_sort(std::begin(new_values),std::end(new_values),compare_first);
+			
+			const auto is_duplicate=[&](const value_type& lhs, const value_type& rhs) { return equal(lhs.first,rhs.first); };
+			new_values.erase(std::unique(std::begin(new_values),std::end(new_values),is_duplicate),std::end(new_values));
+			
+			const auto already_present=[&](const value_type& val) { return find(val.first)!=end(); };
+			new_values.erase(std::remove_if(std::begin(new_values),std::end(new_values),already_present),std::end(new_values));
+			
+			auto old_size=size();
+			auto new_size=old_size+new_values.size();
+			data_.keys.resize(new_size);
+			data_.values.resize(new_size);
+			
+			auto from_new=new_values.size();
+			while(from_new!=0)
+			{
+				--new_size;
+				if(old_size!=0 && key_comp()(new_values[from_new-1].first,data_.keys[old_size-1]))
+				{
+					--old_size;
+					data_.keys[new_size]=std::move(data_.keys[old_size]);
+					data_.values[new_size]=std::move(data_.values[old_size]);
+				}
+				else
+				{
+					--from_new;
+					data_.keys[new_size]=std::move(new_values[from_new].first);
+					data_.values[new_size]=std::move(new_values[from_new].second);
+				}
+			}
+		}
+		
+		constexpr void insert(std::initializer_list<value_type> values)
+		{
+			insert(values.begin(),values.end());
+		}
+		
+		constexpr auto erase(const_iterator pos)
+		{
+			const auto offset=pos.key_iterator()-std::cbegin(data_.keys);
+			data_.keys.erase(pos.key_iterator());
+			data_.values.erase(pos.mapped_iterator());
+			return begin()+offset;
+		}
+		
+		constexpr size_type erase(const key_type& key)
+		{
+			if(auto it=find(key); it!=end())
+			{
+				erase(it);
+				return 1;
+			}
+			return 0;
+		}
+		
+		constexpr auto& operator[](const key_type &key)
+		{
+			auto it=key_lower_bound(key);
+			const auto pos=it-std::cbegin(data_.keys);
+			if(it!=std::cend(data_.keys) && equal(*it,key))
+				return data_.values[pos];
+			
+			data_.keys.insert(it,key);
+			return *data_.values.insert(std::cbegin(data_.values)+pos,MAPPED_T{});
+		}
+		
+		constexpr const auto& operator[](const key_type &key) const
+		{
+			auto it=key_lower_bound(key);
+			if(it!=std::cend(data_.keys) && equal(*it,key))
+				return data_.values[it-std::cbegin(data_.keys)];
+			
+			throw std::out_of_range{"Tried to access nonexistent element with operator[] on a const object..."};
+		}
+		
+		constexpr key_compare key_comp() const { return data_.get_ebo_base(typelist<COMPARE_T>{}); }
+		
+		private:
+		struct member_data: ebo_base<COMPARE_T>
+		{
+			public:
+			constexpr member_data(const COMPARE_T& comp, KEY_CONTAINER_T keys, MAPPED_CONTAINER_T values):
+				ebo_base<COMPARE_T>{comp},
+				keys(std::move(keys)),
+				values(std::move(values))
+			{}
+			
+			KEY_CONTAINER_T keys;
+			MAPPED_CONTAINER_T values;
+		} data_;
+		
+		constexpr bool equal(const key_type& lhs, const key_type& rhs) const
+		{
+			return !key_comp()(lhs,rhs) && !key_comp()(rhs,lhs);
+		}
+		
+		constexpr auto key_lower_bound(const key_type& key) const
+		{
+			return std::lower_bound(std::cbegin(data_.keys),std::cend(data_.keys),key,key_comp());
+		}
+		
+		template <typename const_deduced_self>
+		constexpr static auto find_impl(const_deduced_self& self, const key_type& key)
+		{
+			auto it=self.key_lower_bound(key);
+			if(it==std::cend(self.data_.keys) || !self.equal(*it,key))
+				return self.end();
+			return self.begin()+(it-std::cbegin(self.data_.keys));
+		}
+	};
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>>
+	using fixed_split_flatmap=split_flatmap<KEY_T,MAPPED_T,COMPARE_T,std::array<KEY_T,NUM>,std::array<MAPPED_T,NUM>>;
+	
+	namespace detail
+	{
+		template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T, std::size_t ...IDX>
+		constexpr auto make_fixed_split_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM],std::index_sequence<IDX...>)
+		{
+			std::array<std::pair<KEY_T,MAPPED_T>,NUM> arr{{elements[IDX]...}};
+			
+			const auto compare_first = [&](const auto& lhs, const auto& rhs)
+			{
+				return compare(lhs.first,rhs.first);
+			};
+			
+			ptl::constexpr_algorithm::sort(std::begin(arr),std::end(arr),compare_first);
+			return ptl::fixed_split_flatmap<KEY_T,MAPPED_T,NUM,COMPARE_T>{sorted_unique,compare,{{arr[IDX].first...}},{{arr[IDX].second...}}};
+		}
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM, typename COMPARE_T=std::less<KEY_T>>
+	constexpr auto make_fixed_split_flatmap(COMPARE_T compare, const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_split_flatmap<KEY_T,MAPPED_T,NUM,COMPARE_T>(compare,elements,std::make_index_sequence<NUM>{});
+	}
+	
+	template <typename KEY_T, typename MAPPED_T, std::size_t NUM>
+	constexpr auto make_fixed_split_flatmap(const std::pair<KEY_T,MAPPED_T> (&elements)[NUM])
+	{
+		return detail::make_fixed_split_flatmap<KEY_T,MAPPED_T,NUM,std::less<KEY_T>>(std::less<KEY_T>{},elements,std::make_index_sequence<NUM>{});
+	}
+
+} //end namespace ptl
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_SPSC_QUEUE_H
+#define PHIL_TEMPLATE_LIBRARY_SPSC_QUEUE_H
+
+#include <ptl/fixed_capacity_ring.hpp>
+#include <ptl/fixed_capacity_vector.hpp>
+#include <ptl/new.hpp>
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+/***
+  A bounded queue handing elements from exactly one producer thread to exactly one consumer thread, without locks or allocations.
+  It is a fixed_capacity_ring split in two: the producer owns the tail, the consumer the head, each publishing theirs with a release store
+  and reading the other's with an acquire load. Both live on cache lines of their own, together with the owner's last seen copy of the other index,
+  so the other side's line is only read again when the queue looks full (or empty) by the cached value. Every operation is wait-free.
+  The batched versions move as many elements as fit (or are there) with a single publication.
+***/
+
+namespace ptl
+{
+	template <typename T, std::size_t CAPACITY>
+	class spsc_queue
+	{
+		using indices=detail::ring_indices<CAPACITY>;
+		using index_type=typename indices::index_type;
+		
+		static_assert(std::atomic<index_type>::is_always_lock_free,"spsc_queue needs lock free atomic indices ;_;");
+		
+		public:
+		using value_type	=	T;
+		using size_type		=	std::size_t;
+		
+		spsc_queue() noexcept = default;
+		
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+		
+		//no thread may use the queue anymore by now
+		~spsc_queue() noexcept
+		{
+			for(auto head=consumer_.head.load(std::memory_order_relaxed), tail=producer_.tail.load(std::memory_order_relaxed);head!=tail;head=indices::advance(head,1))
+				slots_.destroy_at(indices::slot(head));
+		}
+		
+		//producer only
+		template <typename... ARGS>
+		bool try_emplace(ARGS&&... args) noexcept(std::is_nothrow_constructible_v<T,ARGS...>)
+		{
+			const auto tail=producer_.tail.load(std::memory_order_relaxed);
+			if(free_slots(tail)==0)
+				return false;
+			
+			slots_.construct_at(indices::slot(tail),std::forward<ARGS>(args)...);
+			producer_.tail.store(indices::advance(tail,1),std::memory_order_release);
+			return true;
+		}
+		
+		bool try_push(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return try_emplace(value); }
+		bool try_push(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) { return try_emplace(std::move(value)); }
+		
+		//producer only. Pushes as many elements of [first,last) as fit and returns the iterator past the last one pushed.
+		template <typename ITER_T>
+		ITER_T try_push(ITER_T first, ITER_T last)
+		{
+			const auto tail=producer_.tail.load(std::memory_order_relaxed);
+			//a batch is worth a fresh look at the head, a stale one might let only part of it in
+			producer_.cached_head=consumer_.head.load(std::memory_order_acquire);
+			const auto available=free_slots(tail);
+			
+			std::size_t count=0;
+			for(;count<available && first!=last;++count,++first)
+				slots_.construct_at(indices::slot(indices::advance(tail,count)),*first);
+			
+			if(count>0)
+				producer_.tail.store(indices::advance(tail,count),std::memory_order_release);
+			return first;
+		}
+		
+		//consumer only
+		bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_destructible_v<T>)
+		{
+			const auto head=consumer_.head.load(std::memory_order_relaxed);
+			if(used_slots(head)==0)
+				return false;
+			
+			auto& slot=slots_[indices::slot(head)];
+			value=std::move(slot);
+			slot.~T();
+			consumer_.head.store(indices::advance(head,1),std::memory_order_release);
+			return true;
+		}
+		
+		//consumer only. Pops up to max_count elements into out and returns how many that were.
+		template <typename OUTPUT_ITER_T>
+		std::size_t try_pop(OUTPUT_ITER_T out, std::size_t max_count)
+		{
+			const auto head=consumer_.head.load(std::memory_order_relaxed);
+			consumer_.cached_tail=producer_.tail.load(std::memory_order_acquire);
+			const auto available=used_slots(head);
+			const auto count=available<max_count?available:max_count;
+			
+			for(std::size_t i=0;i<count;++i,++out)
+			{
+				auto& slot=slots_[indices::slot(indices::advance(head,i))];
+				*out=std::move(slot);
+				slot.~T();
+			}
+			
+			if(count>0)
+				consumer_.head.store(indices::advance(head,count),std::memory_order_release);
+			return count;
+		}
+		
+		//only a snapshot when called while the other side is busy
+		size_type size_approx() const noexcept { return indices::distance(consumer_.head.load(std::memory_order_acquire),producer_.tail.load(std::memory_order_acquire)); }
+		bool empty_approx() const noexcept { return size_approx()==0; }
+		constexpr size_type capacity() const noexcept { return CAPACITY; }
+		
+		private:
+		//producer side, refreshes its view of the head only if the cached one says the queue is full
+		std::size_t free_slots(index_type tail) noexcept
+		{
+			auto available=CAPACITY-indices::distance(producer_.cached_head,tail);
+			if(available==0)
+			{
+				producer_.cached_head=consumer_.head.load(std::memory_order_acquire);
+				available=CAPACITY-indices::distance(producer_.cached_head,tail);
+			}
+			return available;
+		}
+		
+		//consumer side, the other way around
+		std::size_t used_slots(index_type head) noexcept
+		{
+			auto available=indices::distance(head,consumer_.cached_tail);
+			if(available==0)
+			{
+				consumer_.cached_tail=producer_.tail.load(std::memory_order_acquire);
+				available=indices::distance(head,consumer_.cached_tail);
+			}
+			return available;
+		}
+		
+		struct alignas(ptl::hardware_destructive_interference_size) producer_side
+		{
+			std::atomic<index_type> tail{0};
+			index_type cached_head=0;
+		};
+		
+		struct alignas(ptl::hardware_destructive_interference_size) consumer_side
+		{
+			std::atomic<index_type> head{0};
+			index_type cached_tail=0;
+		};
+		
+		producer_side producer_;
+		consumer_side consumer_;
+		alignas(ptl::hardware_destructive_interference_size) detail::uninitialized_array<T,CAPACITY> slots_;
+	};
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PHIL_TEMPLATE_LIBRARY_TYPE_TRAITS_H
+#define PHIL_TEMPLATE_LIBRARY_TYPE_TRAITS_H
+
+#include <type_traits>
+
+namespace ptl
+{
+	//C++20's std::is_constant_evaluated for C++17, as long as the compiler is nice enough to offer the builtin.
+	//Without it, we have no way of knowing and claim to always be constant evaluated, so callers stick to their constexpr safe paths.
+	constexpr bool is_constant_evaluated() noexcept
+	{
+		#ifdef __has_builtin
+		#if __has_builtin(__builtin_is_constant_evaluated)
+		return __builtin_is_constant_evaluated();
+		#endif
+		#endif
+		
+		return true;
+	}
+	
+	//Types whose objects can be moved somewhere else by copying their bytes and forgetting about the original, without any constructor or destructor call.
+	//Not in any standard yet. True for trivially copyable types, specialize it for others that qualify, like most implementations' std::unique_ptr or std::vector.
+	template <typename T>
+	struct is_trivially_relocatable: std::is_trivially_copyable<T> {};
+	
+	template <typename T>
+	inline constexpr bool is_trivially_relocatable_v=is_trivially_relocatable<T>::value;
+
+} //end namespace ptl
+
+#endif